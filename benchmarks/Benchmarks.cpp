@@ -1,4 +1,6 @@
 #include "PluginEditor.h"
+#include "sampler/SincResampler.h"
+#include "sampler/VoicePool.h"
 #include "catch2/benchmark/catch_benchmark_all.hpp"
 #include "catch2/catch_test_macros.hpp"
 
@@ -38,3 +40,182 @@ TEST_CASE ("Boot performance")
         });
     };
 }
+
+static juce::AudioSampleBuffer createSine (int numChannels, int numSamples, double frequency, double sampleRate)
+{
+    juce::AudioSampleBuffer buffer (numChannels, numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < numSamples; ++i)
+            buffer.setSample (ch, i, (float) std::sin (juce::MathConstants<double>::twoPi * frequency * i / sampleRate));
+    return buffer;
+}
+
+static void resampleLagrange (const juce::AudioSampleBuffer& source, double ratio, juce::AudioSampleBuffer& dest)
+{
+    juce::LagrangeInterpolator interpolator;
+    for (int ch = 0; ch < source.getNumChannels(); ++ch)
+    {
+        interpolator.reset();
+        interpolator.process (ratio, source.getReadPointer (ch), dest.getWritePointer (ch), dest.getNumSamples());
+    }
+}
+
+static void resampleSinc (const juce::AudioSampleBuffer& source, double ratio, SincResampler::Quality quality, juce::AudioSampleBuffer& dest)
+{
+    SincResampler resampler (ratio, quality);
+    resampler.process (source, 0, dest.getArrayOfWritePointers(), dest.getNumSamples());
+}
+
+TEST_CASE ("Resampling performance")
+{
+    // ten seconds of stereo from 44.1k to 48k
+    const double ratio = 44100.0 / 48000.0;
+    auto source = createSine (2, 441000, 1000.0, 44100.0);
+    juce::AudioSampleBuffer dest (2, (int) (source.getNumSamples() / ratio));
+
+    BENCHMARK ("Lagrange")
+    {
+        resampleLagrange (source, ratio, dest);
+        return dest.getSample (0, 0);
+    };
+
+    BENCHMARK ("Sinc draft")
+    {
+        resampleSinc (source, ratio, SincResampler::Quality::draft, dest);
+        return dest.getSample (0, 0);
+    };
+
+    BENCHMARK ("Sinc standard")
+    {
+        resampleSinc (source, ratio, SincResampler::Quality::standard, dest);
+        return dest.getSample (0, 0);
+    };
+
+    BENCHMARK ("Sinc mastering")
+    {
+        resampleSinc (source, ratio, SincResampler::Quality::mastering, dest);
+        return dest.getSample (0, 0);
+    };
+}
+
+TEST_CASE ("Resampling quality")
+{
+    // a 23 kHz tone has no place below the 22.05 kHz Nyquist of the destination,
+    // so everything left in the output is aliasing
+    const double ratio = 48000.0 / 44100.0;
+    auto source = createSine (1, 48000, 23000.0, 48000.0);
+    juce::AudioSampleBuffer dest (1, (int) (source.getNumSamples() / ratio));
+
+    auto measureAliasing = [&] (auto&& resample)
+    {
+        resample (dest);
+        auto skip = 256;
+        return juce::Decibels::gainToDecibels (dest.getRMSLevel (0, skip, dest.getNumSamples() - 2 * skip));
+    };
+
+    auto lagrange = measureAliasing ([&] (auto& d) { resampleLagrange (source, ratio, d); });
+    auto draft = measureAliasing ([&] (auto& d) { resampleSinc (source, ratio, SincResampler::Quality::draft, d); });
+    auto standard = measureAliasing ([&] (auto& d) { resampleSinc (source, ratio, SincResampler::Quality::standard, d); });
+    auto mastering = measureAliasing ([&] (auto& d) { resampleSinc (source, ratio, SincResampler::Quality::mastering, d); });
+
+    WARN ("Aliasing in dB, Lagrange: " << lagrange << ", draft: " << draft << ", standard: " << standard << ", mastering: " << mastering);
+
+    CHECK (standard < lagrange);
+    CHECK (mastering < standard);
+}
+
+static std::unique_ptr<juce::AudioFormatReader> createReader (const juce::AudioSampleBuffer& buffer, double sampleRate)
+{
+    auto block = std::make_unique<juce::MemoryBlock>();
+    {
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (new juce::MemoryOutputStream (*block, false), sampleRate, (unsigned int) buffer.getNumChannels(), 32, {}, 0));
+        writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+    }
+
+    juce::WavAudioFormat wav;
+    return std::unique_ptr<juce::AudioFormatReader> (wav.createReaderFor (new juce::MemoryInputStream (std::move (*block)), true));
+}
+
+TEST_CASE ("Voice mixing performance")
+{
+    // one second of 512 frame blocks, cost should grow linearly with the number of voices
+    const int blockSize = 512, numBlocks = 94;
+    auto reader = createReader (createSine (2, blockSize * numBlocks, 1000.0, 48000.0), 48000.0);
+    Sample sample (*reader, 48000.0);
+
+    juce::AudioFormatManager formatManager;
+    SampleStreamer streamer (formatManager, VoicePool::maxStreams, 2);
+    VoicePool voices (streamer);
+    voices.prepare (48000.0, 2, blockSize);
+
+    juce::AudioSampleBuffer output (2, blockSize);
+
+    for (auto numVoices : { 1, 8, VoicePool::maxVoices })
+    {
+        BENCHMARK (std::to_string (numVoices) + " voices")
+        {
+            for (int i = 0; i < numVoices; ++i)
+                voices.start (&sample, nullptr, 0, sample.getNumSamples());
+
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                output.clear();
+                voices.render (output, 0, blockSize);
+            }
+
+            voices.stopAll();
+            return output.getSample (0, 0);
+        };
+    }
+}
+
+TEST_CASE ("Varispeed performance")
+{
+    // eight voices a semitone down against the same voices on the direct copy path
+    const int blockSize = 512, numBlocks = 94, numVoices = 8;
+    auto reader = createReader (createSine (2, blockSize * numBlocks, 1000.0, 48000.0), 48000.0);
+    Sample sample (*reader, 48000.0);
+
+    juce::AudioFormatManager formatManager;
+    SampleStreamer streamer (formatManager, VoicePool::maxStreams, 2);
+    VoicePool voices (streamer);
+    voices.prepare (48000.0, 2, blockSize);
+
+    juce::AudioSampleBuffer output (2, blockSize);
+
+    auto run = [&] (float speed, VarispeedInterpolator::Type type)
+    {
+        voices.setSpeed (speed);
+        voices.setInterpolation (type);
+
+        for (int i = 0; i < numVoices; ++i)
+            voices.start (&sample, nullptr, 0, sample.getNumSamples());
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            output.clear();
+            voices.render (output, 0, blockSize);
+        }
+
+        voices.stopAll();
+        return output.getSample (0, 0);
+    };
+
+    const auto semitoneDown = std::exp2 (-1.0f / 12.0f);
+
+    BENCHMARK ("Direct copy")
+    {
+        return run (1.0f, VarispeedInterpolator::Type::cubic);
+    };
+
+    BENCHMARK ("Cubic")
+    {
+        return run (semitoneDown, VarispeedInterpolator::Type::cubic);
+    };
+
+    BENCHMARK ("Windowed sinc")
+    {
+        return run (semitoneDown, VarispeedInterpolator::Type::sinc);
+    };
+}
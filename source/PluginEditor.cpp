@@ -7,12 +7,27 @@ PluginEditor::PluginEditor(PluginProcessor& p)
     globalParams(new juce::GenericAudioProcessorEditor(p)),
     inspectButton(new juce::TextButton("Inspect the UI"))
 {
-    pluginProcessor.mainProcessor->addChangeListener(this);
+    pluginProcessor.addChangeListener(this);
     
     headerComp.addAndMakeVisible(*globalParams);
     headerComp.addAndMakeVisible(*inspectButton);
+    headerComp.addAndMakeVisible(addEffectBox);
+    headerComp.addAndMakeVisible(removeEffectButton);
     addAndMakeVisible(headerComp);
     
+    // effects go on the end of the chain and come off it from the end
+    addEffectBox.setTextWhenNothingSelected("Add effect");
+    addEffectBox.addItemList(PluginProcessor::getEffectNames(), 1);
+    addEffectBox.onChange = [this] {
+        pluginProcessor.addEffect(addEffectBox.getText());
+        addEffectBox.setSelectedId(0, juce::dontSendNotification);
+    };
+    
+    removeEffectButton.onClick = [this] {
+        if (pluginProcessor.getNumEffects() > 0)
+            pluginProcessor.removeEffect(&pluginProcessor.getEffect(pluginProcessor.getNumEffects() - 1));
+    };
+    
     inspectButton->onClick = [&] {
         if (!inspector)
         {
@@ -23,17 +38,13 @@ PluginEditor::PluginEditor(PluginProcessor& p)
         inspector->setVisible (true);
     };
     
-    for (auto node : pluginProcessor.mainProcessor->getNodes())
-        if (node->getProcessor()->hasEditor())
-            procComp.addAndMakeVisible(node->getProcessor()->createEditor());
     addAndMakeVisible(procComp);
-    
-    setSize (600, 800);
+    createProcessorEditors();
 }
 
 PluginEditor::~PluginEditor()
 {
-    pluginProcessor.mainProcessor->removeChangeListener(this);
+    pluginProcessor.removeChangeListener(this);
     procComp.deleteAllChildren();
 }
 
@@ -41,8 +52,27 @@ PluginEditor::~PluginEditor()
 
 void PluginEditor::changeListenerCallback(juce::ChangeBroadcaster* source)
 {
-    //TODO: here we can catch AudioProcessorGraph changes
     juce::ignoreUnused(source);
+    createProcessorEditors();
+}
+
+void PluginEditor::createProcessorEditors()
+{
+    procComp.deleteAllChildren();
+    
+    for (int i = 0; i < pluginProcessor.getNumSamplers(); ++i)
+        procComp.addAndMakeVisible(pluginProcessor.getSampler(i).createEditor());
+    
+    for (int i = 0; i < pluginProcessor.getNumEffects(); ++i)
+        if (pluginProcessor.getEffect(i).hasEditor())
+            procComp.addAndMakeVisible(pluginProcessor.getEffect(i).createEditor());
+    
+    auto height = 40;
+    for (auto component : procComp.getChildren())
+        height += component->getHeight();
+    
+    setSize(600, juce::jmax(800, height));
+    resized();
 }
 
 #pragma mark -
@@ -53,7 +83,12 @@ void PluginEditor::resized()
     
     headerComp.setBounds(area.removeFromTop(40));
     globalParams->setBounds(headerComp.getLocalBounds().removeFromLeft(area.getCentreX()));
-    inspectButton->setBounds(headerComp.getLocalBounds().removeFromRight(area.getCentreX()).reduced(10));
+    
+    auto controls = headerComp.getLocalBounds().removeFromRight(area.getCentreX());
+    auto controlWidth = controls.getWidth() / 3;
+    inspectButton->setBounds(controls.removeFromLeft(controlWidth).reduced(10));
+    addEffectBox.setBounds(controls.removeFromLeft(controlWidth).reduced(10));
+    removeEffectButton.setBounds(controls.reduced(10));
     
     procComp.setBounds(area);
     auto procArea = procComp.getLocalBounds();
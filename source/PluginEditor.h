@@ -22,9 +22,13 @@ private:
     std::unique_ptr<juce::GenericAudioProcessorEditor> globalParams;
     std::unique_ptr<melatonin::Inspector> inspector;
     std::unique_ptr<juce::TextButton> inspectButton;
+    juce::ComboBox addEffectBox;
+    juce::TextButton removeEffectButton { "Remove effect" };
     
     juce::Component headerComp { "Global" };
     juce::Component procComp { "Processors" };
     
+    void createProcessorEditors();
+    
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginEditor)
 };
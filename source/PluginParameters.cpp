@@ -3,10 +3,10 @@
 
 
 PluginParameters::PluginParameters(juce::AudioProcessor& proc)
-    : parameters(proc)
+    : parameters(proc),
+    bypassHandle(parameters.addBool("bypass", { "bypass", schema }, "Bypass", false)),
+    numsamplersHandle(parameters.addInt("numsamplers", { "numsamplers", schema }, "Number of samplers", 1, maxsamplers, 1))
 {
-    parameters.add("bypass", new juce::AudioParameterBool({ "bypass", schema }, "Bypass", false, juce::AudioParameterBoolAttributes()));
-    parameters.add("numsamplers", new juce::AudioParameterInt({ "numsamplers", schema }, "Number of samplers", 1, maxsamplers, 1));
 }
 
 PluginParameters::~PluginParameters()
@@ -37,12 +37,12 @@ juce::AudioProcessorParameter* PluginParameters::raw(const std::string& id) cons
 
 bool PluginParameters::bypass() const
 {
-    return parameters.get<bool>("bypass");
+    return parameters.get(bypassHandle);
 }
 
-int PluginParameters::numsamplers(const int newnumsamplers) const
+int PluginParameters::numsamplers() const
 {
-    return std::max(newnumsamplers, maxsamplers);
+    return parameters.get(numsamplersHandle);
 }
 
 #pragma mark -
@@ -61,8 +61,8 @@ void PluginParameters::read(const void* data, const int size)
         if (xml->hasTagName("BanditexPlugin") == false) { return; }
         if (xml->getIntAttribute("schema") != schema) { return; }
         
-        parameters.read<bool>("bypass", *xml);
-        parameters.read<int>("numsamplers", *xml);
+        parameters.read(bypassHandle, *xml);
+        parameters.read(numsamplersHandle, *xml);
     }
     catch(const std::exception& exception)
     {
@@ -78,8 +78,8 @@ void PluginParameters::write(juce::MemoryBlock& data)
         auto xml = std::make_unique<juce::XmlElement>("BanditexPlugin");
         xml->setAttribute("schema", schema);
         
-        parameters.write<bool>("bypass", *xml);
-        parameters.write<int>("numsamplers", *xml);
+        parameters.write(bypassHandle, *xml);
+        parameters.write(numsamplersHandle, *xml);
         
         DBG(xml->toString(juce::XmlElement::TextFormat().withoutHeader()));
         juce::AudioProcessor::copyXmlToBinary(*xml, data);
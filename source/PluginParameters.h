@@ -1,11 +1,13 @@
 #pragma once
 
-#include "parameters/GenericParameterContainer.h"
+#include "parameters/ParameterRegistry.h"
 
 
 class PluginParameters final
 {
 public:
+    static constexpr int maxsamplers = 5;
+    
     explicit PluginParameters(juce::AudioProcessor& proc);
     ~PluginParameters();
     
@@ -16,7 +18,7 @@ public:
     juce::AudioProcessorParameter* raw(const std::string& id) const;
     
     bool bypass() const;
-    int numsamplers(const int newnumsamplers) const;
+    int numsamplers() const;
     
     void read(const void* data, const int size);
     void write(juce::MemoryBlock& data);
@@ -24,7 +26,8 @@ public:
 private:
     
     const int schema = 1;
-    const int maxsamplers = 5;
     
-    GenericParameterContainer parameters;
+    ParameterRegistry parameters;
+    const ParameterHandle<bool> bypassHandle;
+    const ParameterHandle<int> numsamplersHandle;
 };
@@ -15,17 +15,19 @@ PluginProcessor::PluginProcessor()
             .withOutput("Output", juce::AudioChannelSet::stereo(), true)
         )
 {
-    mainProcessor = std::make_unique<juce::AudioProcessorGraph>();
     parameters = std::make_unique<PluginParameters>(*this);
     
-    audioOutputNode = mainProcessor->addNode(std::make_unique<AudioGraphIOProcessor>(AudioGraphIOProcessor::audioOutputNode));
-    midiInputNode = mainProcessor->addNode(std::make_unique<AudioGraphIOProcessor>(AudioGraphIOProcessor::midiInputNode));
-    midiOutputNode = mainProcessor->addNode(std::make_unique<AudioGraphIOProcessor>(AudioGraphIOProcessor::midiOutputNode));
-    processorNodes.push_back(mainProcessor->addNode(std::make_unique<SamplerProcessor>()));
+    for (auto& sampler : samplers)
+        sampler = std::make_unique<SamplerProcessor>();
+    
+    // lets an open editor show or hide sampler layers
+    parameters->onnumsamplers([this] { numSamplersChanged.store(true); });
+    startTimerHz(10);
 }
 
 PluginProcessor::~PluginProcessor()
 {
+    stopTimer();
 }
 
 #pragma mark -
@@ -149,31 +151,29 @@ void PluginProcessor::setStateInformation (const void* data, int sizeInBytes)
 
 void PluginProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    mainProcessor->setPlayConfigDetails(getMainBusNumInputChannels(),
-                                        getMainBusNumOutputChannels(),
-                                        sampleRate, samplesPerBlock);
-    
-    mainProcessor->prepareToPlay(sampleRate, samplesPerBlock);
+    workers.prepare(sampleRate, samplesPerBlock);
     
-    for (auto connection : mainProcessor->getConnections())
-        mainProcessor->removeConnection(connection);
-    
-    for (auto node : mainProcessor->getNodes())
-        node->getProcessor()->setPlayConfigDetails(mainProcessor->getMainBusNumInputChannels(),
-                                                   mainProcessor->getMainBusNumOutputChannels(),
-                                                   mainProcessor->getSampleRate(),
-                                                   mainProcessor->getBlockSize());
+    for (size_t i = 0; i < samplers.size(); ++i)
+    {
+        samplers[i]->setPlayConfigDetails(getMainBusNumInputChannels(), getMainBusNumOutputChannels(), sampleRate, samplesPerBlock);
+        samplers[i]->enableAllBuses();
+        samplers[i]->prepareToPlay(sampleRate, samplesPerBlock);
+        samplerBuffers[i].setSize(getMainBusNumOutputChannels(), samplesPerBlock);
+        samplerMidi[i].ensureSize(2048);
+        
+        samplerGains[i].reset(sampleRate, CrossfadingChain::fadeSeconds);
+        samplerGains[i].setCurrentAndTargetValue((int) i < getNumSamplers() ? 1.0f : 0.0f);
+    }
     
-    connectAudioNodes();
-    connectMidiNodes();
-
-    for (auto node: mainProcessor->getNodes())
-        node->getProcessor()->enableAllBuses();
+    effects.prepare(getMainBusNumOutputChannels(), sampleRate, samplesPerBlock);
 }
 
 void PluginProcessor::releaseResources()
 {
-    mainProcessor->releaseResources();
+    for (auto& sampler : samplers)
+        sampler->releaseResources();
+    
+    effects.release();
 }
 
 void PluginProcessor::processBlock(juce::AudioBuffer<float>& audioBuffer, juce::MidiBuffer& midiBuffer)
@@ -181,10 +181,13 @@ void PluginProcessor::processBlock(juce::AudioBuffer<float>& audioBuffer, juce::
     for (int i = getTotalNumInputChannels(); i < getTotalNumOutputChannels(); ++i)
         audioBuffer.clear(i, 0, audioBuffer.getNumSamples());
     
-    //TODO: here we can update connections between audio processors (adding/removing samplers)
-
     if (!parameters->bypass())
-        mainProcessor->processBlock(audioBuffer, midiBuffer);
+    {
+        // the samplers replace the host input, the effects then run over their sum
+        audioBuffer.clear();
+        renderSamplers(audioBuffer, midiBuffer);
+        effects.process(audioBuffer, midiBuffer);
+    }
     
     // this is a safety valve to protect us from too loud output
     // it kicks in when there appears to be some garbage in the output buffer (NaN, inf, or amplitude > 2)
@@ -195,38 +198,122 @@ void PluginProcessor::processBlock(juce::AudioBuffer<float>& audioBuffer, juce::
     #endif
 }
 
-#pragma mark -
+void PluginProcessor::audioWorkgroupContextChanged(const juce::AudioWorkgroup& workgroup)
+{
+    workers.setWorkgroup(workgroup);
+}
 
-void PluginProcessor::connectAudioNodes()
+void PluginProcessor::renderSamplers(juce::AudioBuffer<float>& audioBuffer, juce::MidiBuffer& midiBuffer)
 {
-    for (int ch = 0; ch < mainProcessor->getMainBusNumInputChannels(); ++ch)
+    auto numSamples = audioBuffer.getNumSamples();
+    auto numActive = getNumSamplers();
+    juce::uint32 jobs = 0;
+    
+    // a layer switched off keeps rendering until it has faded out
+    for (int i = 0; i < (int) samplers.size(); ++i)
     {
-        switch (processorNodes.size()) {
-            case 0:
-                break;
-            case 1:
-                mainProcessor->addConnection({ { processorNodes.front()->nodeID, ch }, { audioOutputNode->nodeID, ch } });
-                break;
-            default:
-                auto node = processorNodes.begin();
-                do {
-                    NodeAndChannel source = { node->get()->nodeID, ch };
-                    std::advance(node, 1);
-                    NodeAndChannel dest = { node->get()->nodeID, ch };
-                    mainProcessor->addConnection({ source, dest });
-                }
-                while (node != processorNodes.end());
-                
-                mainProcessor->addConnection({ { node->get()->nodeID, ch }, { audioOutputNode->nodeID, ch } });
-                break;
-        }
+        auto& gain = samplerGains[(size_t) i];
+        gain.setTargetValue(i < numActive ? 1.0f : 0.0f);
+        
+        if (!gain.isSmoothing() && gain.getTargetValue() <= 0.0f)
+            continue;
+        
+        samplerMidi[(size_t) i].clear();
+        samplerMidi[(size_t) i].addEvents(midiBuffer, 0, numSamples, 0);
+        jobs |= 1u << i;
     }
+    
+    samplerBlockSize = numSamples;
+    workers.run(jobs);
+    
+    for (int i = 0; i < (int) samplers.size(); ++i)
+    {
+        if ((jobs & (1u << i)) == 0)
+            continue;
+        
+        auto& buffer = samplerBuffers[(size_t) i];
+        auto& gain = samplerGains[(size_t) i];
+        
+        auto startGain = gain.getCurrentValue();
+        gain.skip(numSamples);
+        auto endGain = gain.getCurrentValue();
+        
+        for (int ch = 0; ch < juce::jmin(audioBuffer.getNumChannels(), buffer.getNumChannels()); ++ch)
+            audioBuffer.addFromWithRamp(ch, 0, buffer.getReadPointer(ch), numSamples, startGain, endGain);
+        
+        // a layer stops once it has faded out, so switching it back on never resumes what it played
+        if (!gain.isSmoothing() && gain.getTargetValue() <= 0.0f)
+            samplers[(size_t) i]->stopNow();
+    }
+}
+
+void PluginProcessor::renderSampler(int index)
+{
+    // layers share nothing, so any thread of the pool can render any of them
+    auto& buffer = samplerBuffers[(size_t) index];
+    buffer.setSize(buffer.getNumChannels(), samplerBlockSize, false, false, true);
+    buffer.clear();
+    samplers[(size_t) index]->processBlock(buffer, samplerMidi[(size_t) index]);
+}
+
+void PluginProcessor::timerCallback()
+{
+    if (numSamplersChanged.exchange(false))
+        sendChangeMessage();
+}
+
+#pragma mark -
+
+int PluginProcessor::getNumSamplers() const
+{
+    return parameters->numsamplers();
+}
+
+juce::AudioProcessor& PluginProcessor::getSampler(int index) const
+{
+    return *samplers[(size_t) index];
+}
+
+bool PluginProcessor::addEffect(std::unique_ptr<juce::AudioProcessor> effect, int position)
+{
+    if (!effects.add(std::move(effect), position))
+        return false;
+    
+    sendChangeMessage();
+    return true;
+}
+
+bool PluginProcessor::addEffect(const juce::String& name)
+{
+    if (name == "Gain")
+        return addEffect(std::make_unique<GainProcessor>());
+    
+    if (name == "Level")
+        return addEffect(std::make_unique<LevelProcessor>());
+    
+    return false;
+}
+
+juce::StringArray PluginProcessor::getEffectNames()
+{
+    return { "Gain", "Level" };
+}
+
+void PluginProcessor::removeEffect(juce::AudioProcessor* effect)
+{
+    // the editor drops the effect's editor now, before the chain can free the effect
+    effects.remove(effect);
+    sendSynchronousChangeMessage();
+}
+
+int PluginProcessor::getNumEffects() const
+{
+    return effects.size();
 }
 
-void PluginProcessor::connectMidiNodes()
+juce::AudioProcessor& PluginProcessor::getEffect(int index) const
 {
-    auto ch = juce::AudioProcessorGraph::midiChannelIndex;
-    mainProcessor->addConnection({ { midiInputNode->nodeID, ch }, { midiOutputNode->nodeID, ch } });
+    return *effects.get(index);
 }
 
 #pragma mark -
@@ -2,18 +2,18 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include "PluginParameters.h"
+#include "processors/CrossfadingChain.h"
+#include "utils/RealtimeWorkerPool.h"
 
 #if (MSVC)
 #include "ipps.h"
 #endif
 
-class PluginProcessor final : public juce::AudioProcessor
+class SamplerProcessor;
+
+class PluginProcessor final : public juce::AudioProcessor, public juce::ChangeBroadcaster, private juce::Timer
 {
 public:
-    using AudioGraphIOProcessor = juce::AudioProcessorGraph::AudioGraphIOProcessor;
-    using NodeAndChannel = juce::AudioProcessorGraph::NodeAndChannel;
-    using Node = juce::AudioProcessorGraph::Node;
-    
     PluginProcessor();
     ~PluginProcessor() override;
 
@@ -41,19 +41,41 @@ public:
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
     void processBlock (juce::AudioBuffer<float>& audioBuffer, juce::MidiBuffer& midiBuffer) override;
+    void audioWorkgroupContextChanged (const juce::AudioWorkgroup& workgroup) override;
+    
+    int getNumSamplers() const;
+    juce::AudioProcessor& getSampler(int index) const;
+    
+    // message thread: effects run in order over the summed samplers and can be edited during playback
+    bool addEffect(std::unique_ptr<juce::AudioProcessor> effect, int position = -1);
+    bool addEffect(const juce::String& name);
+    static juce::StringArray getEffectNames();
+    void removeEffect(juce::AudioProcessor* effect);
+    int getNumEffects() const;
+    juce::AudioProcessor& getEffect(int index) const;
 
-    //TODO: figure out how to make it private:
-    std::unique_ptr<juce::AudioProcessorGraph> mainProcessor;
 private:
     std::unique_ptr<PluginParameters> parameters;
     
-    Node::Ptr audioOutputNode;
-    Node::Ptr midiInputNode;
-    Node::Ptr midiOutputNode;
-    std::vector<Node::Ptr> processorNodes;
+    // every layer is built and prepared up front, numsamplers only decides how many of them render;
+    // a layer switched on or off fades over the same time as an effect joining or leaving the chain.
+    // Layers share their loading and streaming threads, so the idle ones start no threads of their own
+    std::array<std::unique_ptr<SamplerProcessor>, PluginParameters::maxsamplers> samplers;
+    std::array<juce::AudioBuffer<float>, PluginParameters::maxsamplers> samplerBuffers;
+    std::array<juce::SmoothedValue<float>, PluginParameters::maxsamplers> samplerGains;
+    
+    // each layer gets its own copy of the block's MIDI, as processBlock is free to change what it's given
+    std::array<juce::MidiBuffer, PluginParameters::maxsamplers> samplerMidi;
+    int samplerBlockSize = 0;
+    RealtimeWorkerPool workers { juce::jlimit(0, PluginParameters::maxsamplers - 1, juce::SystemStats::getNumCpus() - 1), [this] (int index) { renderSampler(index); } };
+    CrossfadingChain effects;
+    
+    // numsamplers can be automated from the audio thread, so the editor hears about it from a timer
+    std::atomic<bool> numSamplersChanged { false };
     
-    void connectAudioNodes();
-    void connectMidiNodes();
+    void renderSamplers(juce::AudioBuffer<float>& audioBuffer, juce::MidiBuffer& midiBuffer);
+    void renderSampler(int index);
+    void timerCallback() override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginProcessor)
 };
@@ -3,10 +3,14 @@
 
 
 SamplerEditor::SamplerEditor(SamplerProcessor& p, juce::AudioProcessorValueTreeState& vst)
-    : AudioProcessorEditor(&p), samplerProcessor(p), params(vst)
+    : AudioProcessorEditor(&p), samplerProcessor(p), params(vst),
+    loadingBar(p.getLoadingProgress())
 {
     samplerProcessor.addChangeListener(this);
     
+    // events queued while no editor was open are stale, start from where playback is now
+    samplerProcessor.drainEvents([] (const SamplerProcessor::PlaybackEvent&) {});
+    
     addAndMakeVisible(bypassToggle);
     bypassToggle.setButtonText("Bypass");
     bypassAttachment.reset(new ButtonAttachment(params, "bypass", bypassToggle));
@@ -16,10 +20,10 @@ SamplerEditor::SamplerEditor(SamplerProcessor& p, juce::AudioProcessorValueTreeS
     playStopButton.setClickingTogglesState(true);
     playStopButton.onClick = [this] { playStopButtonClicked(); };
     
-    addAndMakeVisible(shuffleButton);
-    shuffleButton.setButtonText("Shuffle");
-    shuffleButton.setClickingTogglesState(true);
-    shuffleAttachment.reset(new ButtonAttachment(params, "shuffle", shuffleButton));
+    addAndMakeVisible(playbackOrderBox);
+    playbackOrderBox.setTooltip("Playback order");
+    playbackOrderBox.addItemList(params.getParameter("playbackorder")->getAllValueStrings(), 1);
+    playbackOrderAttachment.reset(new ComboBoxAttachment(params, "playbackorder", playbackOrderBox));
     
     addAndMakeVisible(loopButton);
     loopButton.setButtonText("Loop");
@@ -39,6 +43,8 @@ SamplerEditor::SamplerEditor(SamplerProcessor& p, juce::AudioProcessorValueTreeS
     filesList.setClickingTogglesRowSelection(false);
     filesList.setRowHeight(30);
     
+    addChildComponent(loadingBar);
+    
     //addAndMakeVisible(waveformDisplay);
     
     addAndMakeVisible(pitchSlider);
@@ -61,11 +67,34 @@ SamplerEditor::SamplerEditor(SamplerProcessor& p, juce::AudioProcessorValueTreeS
     levelLabel.setJustificationType(juce::Justification::centred);
     levelLabel.setText("LEVEL", juce::NotificationType::dontSendNotification);
     
-    setSize(300, 200);
+    addAndMakeVisible(storageBox);
+    storageBox.setTooltip("Sample storage");
+    storageBox.addItemList(params.getParameter("storage")->getAllValueStrings(), 1);
+    storageAttachment.reset(new ComboBoxAttachment(params, "storage", storageBox));
+    
+    addAndMakeVisible(loopModeBox);
+    loopModeBox.setTooltip("Loop mode");
+    loopModeBox.addItemList(params.getParameter("loopmode")->getAllValueStrings(), 1);
+    loopModeBox.onChange = [this] { loopModeChanged(); };
+    loopModeAttachment.reset(new ComboBoxAttachment(params, "loopmode", loopModeBox));
+    
+    addAndMakeVisible(loopValueSlider);
+    loopValueSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    loopValueSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxRight, false, 50, 20);
+    loopModeChanged();
+    
+    playStopButton.setToggleState(samplerProcessor.isPlaying(), juce::NotificationType::dontSendNotification);
+    
+    if (samplerProcessor.isPlaying() && samplerProcessor.getCurrentSampleIndex() > -1)
+        filesList.selectRow(samplerProcessor.getCurrentSampleIndex());
+    
+    setSize(300, 230);
+    startTimerHz(30);
 }
 
 SamplerEditor::~SamplerEditor()
 {
+    stopTimer();
     samplerProcessor.removeChangeListener(this);
     loadedFiles.clear();
 }
@@ -74,12 +103,44 @@ SamplerEditor::~SamplerEditor()
 
 void SamplerEditor::changeListenerCallback (juce::ChangeBroadcaster*)
 {
-    playStopButton.setToggleState(!samplerProcessor.isSuspended(), juce::NotificationType::dontSendNotification);
+    if (loadingBar.isVisible() != samplerProcessor.isLoading())
+    {
+        loadingBar.setVisible(samplerProcessor.isLoading());
+        filesList.repaint();
+    }
+}
+
+void SamplerEditor::timerCallback()
+{
+    using Type = SamplerProcessor::PlaybackEvent::Type;
     
-    if (!samplerProcessor.isSuspended() && samplerProcessor.getCurrentSampleIndex() > -1)
-        filesList.selectRow(samplerProcessor.getCurrentSampleIndex());
-    else
-        filesList.deselectAllRows();
+    samplerProcessor.drainEvents([this] (const SamplerProcessor::PlaybackEvent& event)
+    {
+        switch (event.type)
+        {
+            case Type::sampleStarted:
+                filesList.selectRow(event.ordinal);
+                break;
+            
+            case Type::sampleEnded:
+                if (filesList.isRowSelected(event.ordinal))
+                    filesList.deselectRow(event.ordinal);
+                break;
+            
+            case Type::playlistWrapped:
+                // the next sample's own start event moves the selection back up the list
+                break;
+            
+            case Type::transportStarted:
+                playStopButton.setToggleState(true, juce::NotificationType::dontSendNotification);
+                break;
+            
+            case Type::transportStopped:
+                playStopButton.setToggleState(false, juce::NotificationType::dontSendNotification);
+                filesList.deselectAllRows();
+                break;
+        }
+    });
 }
 
 void SamplerEditor::resized()
@@ -88,9 +149,14 @@ void SamplerEditor::resized()
     auto buttons = area.removeFromTop(40);
     auto buttonWidth = area.getWidth() / 6;
     
+    auto bottom = area.removeFromBottom(30);
+    storageBox.setBounds(bottom.removeFromLeft(100).reduced(4));
+    loopModeBox.setBounds(bottom.removeFromLeft(80).reduced(4));
+    loopValueSlider.setBounds(bottom.reduced(4));
+    
     bypassToggle.setBounds(buttons.removeFromLeft(buttonWidth).reduced(10));
     playStopButton.setBounds(buttons.removeFromLeft(buttonWidth).reduced(10));
-    shuffleButton.setBounds(buttons.removeFromLeft(buttonWidth).reduced(10));
+    playbackOrderBox.setBounds(buttons.removeFromLeft(buttonWidth).reduced(2, 10));
     loopButton.setBounds(buttons.removeFromLeft(buttonWidth).reduced(10));
     openButton.setBounds(buttons.removeFromLeft(buttonWidth).reduced(10));
     clearButton.setBounds(buttons.reduced(10));
@@ -104,7 +170,29 @@ void SamplerEditor::resized()
     pitchSlider.setBounds(pitch);
     
     filesList.setBounds(area);
+    loadingBar.setBounds(area.removeFromBottom(20));
+}
+
+void SamplerEditor::loopModeChanged()
+{
+    auto parameterID = [] (LoopMode::Mode mode) -> juce::String
+    {
+        switch (mode)
+        {
+            case LoopMode::Mode::none:    return {};
+            case LoopMode::Mode::fade:    return "fadelength";
+            case LoopMode::Mode::trigger: return "triggerrate";
+            case LoopMode::Mode::gap:     return "gaplength";
+        }
+        
+        return {};
+    }((LoopMode::Mode) juce::jmax(0, loopModeBox.getSelectedItemIndex()));
     
+    loopValueAttachment.reset();
+    loopValueSlider.setEnabled(parameterID.isNotEmpty());
+    
+    if (parameterID.isNotEmpty())
+        loopValueAttachment.reset(new SliderAttachment(params, parameterID, loopValueSlider));
 }
 
 void SamplerEditor::paint(juce::Graphics &g)
@@ -121,31 +209,31 @@ int SamplerEditor::getNumRows()
 
 void SamplerEditor::paintListBoxItem (int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected)
 {
-    auto& waveformPeaks = samplerProcessor.getWaveformPeaks(); // Ensure this method exists and is public in SamplerProcessor
+    auto& waveformPeaks = samplerProcessor.getWaveformPeaks();
 
-    if (rowNumber < static_cast<int>(waveformPeaks.size())) {
+    if (rowNumber < static_cast<int>(waveformPeaks.size()) && waveformPeaks[static_cast<size_t>(rowNumber)] != nullptr) {
         
-        const auto& buffer = waveformPeaks[static_cast<size_t>(rowNumber)];
-        auto numSamples = buffer.getNumSamples();
-        int ratio = 64;  // downsample ratio for waveform display
-        juce::Path waveformPath;
-        audioPoints.clear();  // clear previous data
-
-        // Collect points for waveform display
-        for (int sample = 0; sample < numSamples; sample += ratio) {
-            float normalizedSample = juce::jmap(buffer.getSample(0, sample), -1.0f, 1.0f, float(height), 0.0f);
-            audioPoints.push_back(normalizedSample);
-        }
+        // Pick the pyramid level closest to one range per pixel, so painting is O(width)
+        const auto& level = waveformPeaks[static_cast<size_t>(rowNumber)]->getLevelFor(width);
+        auto numPoints = static_cast<int>(level.size());
 
-        // Create the waveform path
-        waveformPath.startNewSubPath(0, audioPoints[0]);
-        for (size_t i = 1; i < audioPoints.size(); ++i) {
-            waveformPath.lineTo(static_cast<float>(i), audioPoints[i]);
-        }
-
-        // Set colors and draw the path
         g.setColour(rowIsSelected ? juce::Colours::lightblue : juce::Colours::grey);
-        g.strokePath(waveformPath, juce::PathStrokeType(1.0f));
+        
+        // drawn at the sound's own gain, so a quieter sound looks quieter
+        auto gain = samplerProcessor.getSampleGain(rowNumber);
+        
+        for (int x = 0; x < width && numPoints > 0; ++x) {
+            auto first = x * numPoints / width;
+            auto last = juce::jmax(first + 1, (x + 1) * numPoints / width);
+            auto range = level[static_cast<size_t>(first)];
+            
+            for (auto point = first + 1; point < juce::jmin(last, numPoints); ++point)
+                range = range.getUnionWith(level[static_cast<size_t>(point)]);
+            
+            auto top = juce::jmap(range.getEnd() * gain, -1.0f, 1.0f, float(height), 0.0f);
+            auto bottom = juce::jmap(range.getStart() * gain, -1.0f, 1.0f, float(height), 0.0f);
+            g.drawVerticalLine(x, top, juce::jmax(bottom, top + 1.0f));
+        }
 
         // Draw file name
         //g.setColour(juce::LookAndFeel::getDefaultLookAndFeel().findColour(juce::Label::textColourId));
@@ -154,6 +242,33 @@ void SamplerEditor::paintListBoxItem (int rowNumber, juce::Graphics& g, int widt
     }
 }
 
+void SamplerEditor::listBoxItemClicked (int row, const juce::MouseEvent& event)
+{
+    if (!event.mods.isPopupMenu())
+        return;
+    
+    // a right click on a row sets that sound's gain
+    juce::PopupMenu menu;
+    juce::Component::SafePointer<SamplerEditor> editor(this);
+    auto currentGain = samplerProcessor.getSampleGain(row);
+    
+    for (auto decibels : { 0.0f, -3.0f, -6.0f, -12.0f, -24.0f })
+    {
+        auto gain = juce::Decibels::decibelsToGain(decibels);
+        
+        menu.addItem(juce::String(decibels, 0) + " dB", true, juce::approximatelyEqual(gain, currentGain), [editor, row, gain]
+        {
+            if (editor == nullptr)
+                return;
+            
+            editor->samplerProcessor.setSampleGain(row, gain);
+            editor->filesList.repaintRow(row);
+        });
+    }
+    
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&filesList));
+}
+
 
 #pragma mark -
 
@@ -165,7 +280,10 @@ void SamplerEditor::playStopButtonClicked()
         return;
     }
     
-    samplerProcessor.suspendProcessing(!playStopButton.getToggleState());
+    if (playStopButton.getToggleState())
+        samplerProcessor.play();
+    else
+        samplerProcessor.stop();
 }
 
 void SamplerEditor::openButtonClicked()
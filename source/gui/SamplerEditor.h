@@ -6,7 +6,8 @@
 
 class SamplerEditor : public juce::AudioProcessorEditor,
                       public juce::ChangeListener,
-                      public juce::ListBoxModel
+                      public juce::ListBoxModel,
+                      private juce::Timer
 {
 public:
     explicit SamplerEditor (SamplerProcessor&, juce::AudioProcessorValueTreeState&);
@@ -18,10 +19,12 @@ public:
     
     int getNumRows() override;
     void paintListBoxItem (int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected) override;
+    void listBoxItemClicked (int row, const juce::MouseEvent& event) override;
 
 private:
     using ButtonAttachment = juce::AudioProcessorValueTreeState::ButtonAttachment;
     using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+    using ComboBoxAttachment = juce::AudioProcessorValueTreeState::ComboBoxAttachment;
     
     SamplerProcessor& samplerProcessor;
     juce::AudioProcessorValueTreeState& params;
@@ -30,14 +33,13 @@ private:
     juce::TextButton openButton;
     juce::TextButton clearButton;
     juce::ListBox filesList;
+    juce::ProgressBar loadingBar;
     
-    std::vector<float> audioPoints;
-
     juce::ToggleButton bypassToggle;
     std::unique_ptr<ButtonAttachment> bypassAttachment;
     
-    juce::TextButton shuffleButton;
-    std::unique_ptr<ButtonAttachment> shuffleAttachment;
+    juce::ComboBox playbackOrderBox;
+    std::unique_ptr<ComboBoxAttachment> playbackOrderAttachment;
     
     juce::TextButton loopButton;
     std::unique_ptr<ButtonAttachment> loopAttachment;
@@ -53,10 +55,22 @@ private:
     std::unique_ptr<SliderAttachment> levelAttachment;
     juce::Label levelLabel;
     
+    juce::ComboBox storageBox;
+    std::unique_ptr<ComboBoxAttachment> storageAttachment;
+    
+    juce::ComboBox loopModeBox;
+    std::unique_ptr<ComboBoxAttachment> loopModeAttachment;
+    
+    // edits whichever parameter belongs to the selected loop mode
+    juce::Slider loopValueSlider;
+    std::unique_ptr<SliderAttachment> loopValueAttachment;
+    
 
     void playStopButtonClicked();
     void openButtonClicked();
     void clearButtonClicked();
+    void loopModeChanged();
+    void timerCallback() override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SamplerEditor)
 };
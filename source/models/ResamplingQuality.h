@@ -0,0 +1,11 @@
+#pragma once
+
+
+// How closely resampling keeps to the source. Samples are loaded at one of these and
+// SincResampler picks its kernel from it.
+enum class ResamplingQuality
+{
+    draft,
+    standard,
+    mastering
+};
@@ -1,17 +1,92 @@
 
 #include "Sample.h"
+#include "sampler/SincResampler.h"
 
 
-Sample::Sample(juce::AudioFormatReader& reader, double maxLengthSeconds, double destSampleRate) :
+Sample::Sample(juce::AudioFormatReader& reader, double destSampleRate, const DecodeOptions& options) :
+    Sample(reader, (double) reader.lengthInSamples / reader.sampleRate, destSampleRate, options)
+{
+}
+
+Sample::Sample(juce::AudioFormatReader& reader, double maxLengthSeconds, double destSampleRate, const DecodeOptions& options) :
+    sampleRate(reader.sampleRate),
+    numSamples(juce::jmin(reader.lengthInSamples, (juce::int64) (maxLengthSeconds * sampleRate + 0.5))),
+    numChannels(int(reader.numChannels)),
+    encoding(options.encoding)
+{
+    if (numSamples <= 0)
+        throw std::runtime_error("Invalid sample length.");
+    
+    decode(reader, numSamples, numSamples, destSampleRate, options);
+    numSamples = residentLength;
+}
+
+Sample::Sample(const juce::File& sourceFile, juce::AudioFormatReader& reader, double destSampleRate, double residentLengthSeconds, const DecodeOptions& options) :
     sampleRate(reader.sampleRate),
-    numSamples(juce::jmin(int(reader.lengthInSamples), int(maxLengthSeconds * sampleRate))),
-    tempBuffer(int(reader.numChannels), numSamples)
+    numSamples(reader.lengthInSamples),
+    numChannels(int(reader.numChannels)),
+    file(sourceFile),
+    encoding(options.encoding)
 {
-    if (numSamples == 0)
+    if (numSamples <= 0)
         throw std::runtime_error("Invalid sample length.");
     
-    reader.read(&tempBuffer, 0, numSamples, 0, true, true);
-    resample(sampleRate / destSampleRate);
+    auto sourceResidentLength = juce::jmin(numSamples, (juce::int64) (residentLengthSeconds * sampleRate + 0.5));
+    decode(reader, sourceResidentLength, numSamples, destSampleRate, options);
+    
+    numSamples = (juce::int64) ((double) numSamples * destSampleRate / reader.sampleRate);
+}
+
+Sample::Sample(std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader) :
+    sampleRate(reader->sampleRate),
+    numSamples(reader->lengthInSamples),
+    residentLength(reader->lengthInSamples),
+    numChannels(int(reader->numChannels)),
+    file(reader->getFile()),
+    mappedReader(std::move(reader))
+{
+    if (numSamples <= 0 || numChannels > maxMappedChannels)
+        throw std::runtime_error("Invalid mapped sample.");
+}
+
+Sample::Sample(std::unique_ptr<juce::MemoryMappedFile> mapping, size_t dataOffset, int channels, juce::int64 length, double rate) :
+    sampleRate(rate),
+    numSamples(length),
+    residentLength(length),
+    numChannels(channels),
+    mappedCache(std::move(mapping))
+{
+    if (numSamples <= 0 || numChannels <= 0)
+        throw std::runtime_error("Invalid cached sample.");
+    
+    cachedData = static_cast<const float*>(juce::addBytesToPointer(mappedCache->getData(), dataOffset));
+}
+
+Sample::Sample(const Sample& source, Encoding sampleEncoding) :
+    sampleRate(source.sampleRate),
+    numSamples(source.numSamples),
+    residentLength(source.residentLength),
+    numChannels(source.numChannels),
+    file(source.file),
+    encoding(sampleEncoding),
+    quality(source.quality)
+{
+    jassert(!source.isStreamed());
+    allocate(residentLength);
+    
+    juce::HeapBlock<float> block (chunkLength);
+    
+    for (size_t i = 0; i < chunks.size() / (size_t) numChannels; ++i)
+    {
+        auto position = (juce::int64) i * chunkLength;
+        auto length = (int) juce::jmin((juce::int64) chunkLength, residentLength - position);
+        
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            source.read(ch, position, block, length);
+            SampleEncoding::encode(encoding, block, getChunk(ch, i), length);
+        }
+    }
 }
 
 double Sample::getSampleRate() const
@@ -19,32 +94,221 @@ double Sample::getSampleRate() const
     return sampleRate;
 }
 
-int Sample::getNumSamples() const
+juce::int64 Sample::getNumSamples() const
 {
     return numSamples;
 }
 
-const juce::AudioSampleBuffer& Sample::getBuffer() const
+int Sample::getNumChannels() const
+{
+    return numChannels;
+}
+
+bool Sample::isStreamed() const
+{
+    return residentLength < numSamples;
+}
+
+bool Sample::isMapped() const
+{
+    return mappedReader != nullptr || mappedCache != nullptr;
+}
+
+juce::int64 Sample::getResidentLength() const
+{
+    return residentLength;
+}
+
+Sample::Encoding Sample::getEncoding() const
+{
+    return encoding;
+}
+
+const juce::File& Sample::getFile() const
+{
+    return file;
+}
+
+Sample::Quality Sample::getQuality() const
 {
-    return dataBuffer;
+    return quality;
+}
+
+size_t Sample::getMemoryUsage() const
+{
+    return chunks.size() * (size_t) chunkLength * (size_t) SampleEncoding::getBytesPerSample(encoding);
+}
+
+void Sample::read(int channel, juce::int64 position, float* dest, int numToRead, float startGain, float endGain) const
+{
+    jassert(position >= 0 && position + numToRead <= residentLength);
+    
+    // a constant gain is folded into the copy or conversion, a ramp needs a pass of its own
+    auto isRamp = !juce::approximatelyEqual(startGain, endGain);
+    auto gain = isRamp ? 1.0f : startGain;
+    
+    if (mappedReader != nullptr)
+    {
+        std::array<float*, maxMappedChannels> destChannels {};
+        destChannels[(size_t) channel] = dest;
+        mappedReader->read(destChannels.data(), channel + 1, position, numToRead);
+        
+        if (!juce::approximatelyEqual(gain, 1.0f))
+            juce::FloatVectorOperations::multiply(dest, gain, numToRead);
+    }
+    else if (cachedData != nullptr)
+    {
+        juce::FloatVectorOperations::copyWithMultiply(dest, cachedData + (size_t) channel * (size_t) numSamples + (size_t) position, gain, numToRead);
+    }
+    else
+    {
+        for (int offset = 0; offset < numToRead;)
+        {
+            auto chunkIndex = (size_t) ((position + offset) / chunkLength);
+            auto chunkOffset = (int) ((position + offset) % chunkLength);
+            auto numThisTime = juce::jmin(numToRead - offset, chunkLength - chunkOffset);
+            
+            SampleEncoding::decode(encoding, getChunk(channel, chunkIndex) + chunkOffset * SampleEncoding::getBytesPerSample(encoding), dest + offset, numThisTime, gain);
+            offset += numThisTime;
+        }
+    }
+    
+    if (isRamp)
+    {
+        auto step = (endGain - startGain) / (float) numToRead;
+        for (int i = 0; i < numToRead; ++i)
+            dest[i] *= startGain + step * (float) i;
+    }
 }
 
-void Sample::applyGain(const float gain)
+char* Sample::getChunk(int channel, size_t chunkIndex) const
 {
-    dataBuffer.applyGain(gain);
+    return chunks[chunkIndex * (size_t) numChannels + (size_t) channel].get();
 }
 
-void Sample::resample(double sampleRatio)
+void Sample::allocate(juce::int64 length)
 {
-    int newNumSamples = (int) (tempBuffer.getNumSamples() / sampleRatio);
-    dataBuffer.setSize(tempBuffer.getNumChannels(), newNumSamples);
+    auto numChunks = (size_t) ((length + chunkLength - 1) / chunkLength);
+    
+    chunks.clear();
+    chunks.resize(numChunks * (size_t) numChannels);
+    
+    for (auto& chunk : chunks)
+        chunk.malloc((size_t) chunkLength * (size_t) SampleEncoding::getBytesPerSample(encoding));
+}
 
-    juce::LagrangeInterpolator resampler;
-    for (int ch = 0; ch < dataBuffer.getNumChannels(); ++ch)
-        resampler.process(sampleRatio, tempBuffer.getReadPointer(ch), dataBuffer.getWritePointer(ch), dataBuffer.getNumSamples());
+void Sample::decode(juce::AudioFormatReader& reader, juce::int64 numSourceSamples, juce::int64 numAvailable, double destSampleRate, const DecodeOptions& options)
+{
+    const int blockLength = 1 << 15;
+    auto sampleRatio = sampleRate / destSampleRate;
+    
+    std::optional<SincResampler> resampler;
+    if (!juce::approximatelyEqual(sampleRatio, 1.0))
+        resampler.emplace(sampleRatio, options.quality);
+    
+    auto newNumSamples = resampler.has_value() ? resampler->getNumOutputSamples(numSourceSamples) : numSourceSamples;
+    allocate(newNumSamples);
+    
+    auto firstInput = [&] (juce::int64 frame) { return resampler.has_value() ? resampler->getFirstInputFrame(frame) : frame; };
+    auto lastInput = [&] (juce::int64 frame) { return resampler.has_value() ? resampler->getLastInputFrame(frame) : frame; };
     
-    sampleRate /= sampleRatio;
-    numSamples = newNumSamples;
+    // a streamed head reads on past its last frame as far as the kernel reaches, so that
+    // it ends just like the tail the streamer resamples from the same file goes on
+    auto readEnd = juce::jmin(numAvailable, juce::jmax(numSourceSamples, lastInput(newNumSamples - 1) + 1));
+    
+    SampleDecodeScratch ownScratch;
+    auto& scratch = options.scratch != nullptr ? *options.scratch : ownScratch;
+    auto margin = resampler.has_value() ? resampler->getNumTaps() + 2 * (int) std::ceil(sampleRatio) + 8 : 0;
+    scratch.window.setSize(numChannels, blockLength + margin, false, false, true);
+    scratch.output.setSize(numChannels, blockLength, false, false, true);
+    
+    // the window holds source frames [windowStart, windowStart + windowLength)
+    juce::int64 windowStart = 0, readPosition = 0, written = 0;
+    int windowLength = 0;
+    
+    auto throwIfCancelled = [&options]
+    {
+        if (options.cancelled != nullptr && options.cancelled->load(std::memory_order_relaxed))
+            throw std::runtime_error("Decoding cancelled.");
+    };
+    
+    while (written < newNumSamples)
+    {
+        throwIfCancelled();
+        
+        auto numUnneeded = (int) juce::jlimit((juce::int64) 0, (juce::int64) windowLength, firstInput(written) - windowStart);
+        if (numUnneeded > 0)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                std::memmove(scratch.window.getWritePointer(ch), scratch.window.getReadPointer(ch, numUnneeded), (size_t) (windowLength - numUnneeded) * sizeof(float));
+            
+            windowStart += numUnneeded;
+            windowLength -= numUnneeded;
+        }
+        
+        auto numToRead = (int) juce::jmin((juce::int64) (scratch.window.getNumSamples() - windowLength), readEnd - readPosition);
+        if (numToRead > 0)
+        {
+            reader.read(&scratch.window, windowLength, numToRead, readPosition, true, true);
+            
+            if (options.peaks != nullptr)
+                options.peaks->append(scratch.window, windowLength, numToRead);
+            
+            readPosition += numToRead;
+            windowLength += numToRead;
+        }
+        
+        // once everything is read the rest of the source is silence, otherwise stop at the window's end
+        auto numReady = newNumSamples - written;
+        if (readPosition < readEnd)
+        {
+            juce::int64 low = 0, high = numReady;
+            while (low < high)
+            {
+                auto mid = (low + high + 1) / 2;
+                if (lastInput(written + mid - 1) < windowStart + windowLength)
+                    low = mid;
+                else
+                    high = mid - 1;
+            }
+            
+            numReady = low;
+        }
+        
+        auto numToWrite = (int) juce::jmin((juce::int64) blockLength, numReady);
+        jassert(numToWrite > 0 || numToRead > 0);
+        
+        if (numToWrite <= 0)
+            continue;
+        
+        if (resampler.has_value())
+            resampler->process(scratch.window, windowStart, windowLength, written, scratch.output.getArrayOfWritePointers(), numToWrite);
+        else
+            for (int ch = 0; ch < numChannels; ++ch)
+                scratch.output.copyFrom(ch, 0, scratch.window, ch, (int) (written - windowStart), numToWrite);
+        
+        write(written, scratch.output, numToWrite);
+        written += numToWrite;
+    }
+    
+    sampleRate = destSampleRate;
+    residentLength = newNumSamples;
+    quality = options.quality;
+}
+
+void Sample::write(juce::int64 position, const juce::AudioSampleBuffer& source, int numToWrite)
+{
+    auto bytesPerSample = SampleEncoding::getBytesPerSample(encoding);
     
-    tempBuffer.clear();
+    for (int offset = 0; offset < numToWrite;)
+    {
+        auto chunkIndex = (size_t) ((position + offset) / chunkLength);
+        auto chunkOffset = (int) ((position + offset) % chunkLength);
+        auto numThisTime = juce::jmin(numToWrite - offset, chunkLength - chunkOffset);
+        
+        for (int ch = 0; ch < numChannels; ++ch)
+            SampleEncoding::encode(encoding, source.getReadPointer(ch, offset), getChunk(ch, chunkIndex) + chunkOffset * bytesPerSample, numThisTime);
+        
+        offset += numThisTime;
+    }
 }
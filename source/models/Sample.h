@@ -1,23 +1,98 @@
 #pragma once
 
 #include <juce_audio_formats/juce_audio_formats.h>
+#include "models/ResamplingQuality.h"
+#include "sampler/SampleEncoding.h"
 
+class WaveformPeaks;
+
+
+// Working memory for decoding, reused from sample to sample so that loading holds
+// no more than a couple of blocks on top of the decoded frames themselves.
+struct SampleDecodeScratch
+{
+    juce::AudioSampleBuffer window;
+    juce::AudioSampleBuffer output;
+};
+
+struct SampleDecodeOptions
+{
+    ResamplingQuality quality = ResamplingQuality::standard;
+    SampleEncoding::Type encoding = SampleEncoding::float32;
+    
+    // gets every source frame read, so peaks need no pass of their own; for streamed and
+    // capped samples that is only their head
+    WaveformPeaks* peaks = nullptr;
+    SampleDecodeScratch* scratch = nullptr;
+    
+    // checked between blocks, decoding throws once it is set
+    const std::atomic<bool>* cancelled = nullptr;
+};
 
 class Sample final
 {
 public:
-    Sample(juce::AudioFormatReader& reader, double maxLengthSeconds, double destSampleRate);
+    // Sample data lives in fixed-size chunks so that loading never reallocates
+    // what was already decoded and lengths are not limited to int.
+    static constexpr int chunkLength = 1 << 16;
+    
+    using Quality = ResamplingQuality;
+    using Encoding = SampleEncoding::Type;
+    
+    using DecodeOptions = SampleDecodeOptions;
+    
+    // Decoding is a single pass of fixed-size blocks: read, resample, encode into chunks.
+    Sample(juce::AudioFormatReader& reader, double destSampleRate, const DecodeOptions& options = {});
+    Sample(juce::AudioFormatReader& reader, double maxLengthSeconds, double destSampleRate, const DecodeOptions& options = {});
+    
+    // Streamed samples keep only their first residentLengthSeconds in memory,
+    // the rest is read from the file by SampleStreamer while playing.
+    Sample(const juce::File& file, juce::AudioFormatReader& reader, double destSampleRate, double residentLengthSeconds, const DecodeOptions& options = {});
+    
+    // Mapped samples are played straight from the file's pages without decoding or copying.
+    explicit Sample(std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader);
+    static constexpr int maxMappedChannels = 32;
+    
+    // Cached samples are planar float data inside a mapped SampleCache entry.
+    Sample(std::unique_ptr<juce::MemoryMappedFile> mapping, size_t dataOffset, int numChannels, juce::int64 numSamples, double sampleRate);
+    
+    // Re-encodes a fully resident sample, e.g. one coming from the cache.
+    Sample(const Sample& source, Encoding encoding);
     
     double getSampleRate() const;
-    int getNumSamples() const;
-    const juce::AudioSampleBuffer& getBuffer() const;
-    void applyGain(const float gain);
+    juce::int64 getNumSamples() const;
+    int getNumChannels() const;
+    
+    bool isStreamed() const;
+    bool isMapped() const;
+    juce::int64 getResidentLength() const;
+    Encoding getEncoding() const;
+    const juce::File& getFile() const;
+    
+    // the tier the head was resampled with, which the streamer carries on with
+    Quality getQuality() const;
+    
+    // bytes of decoded frames held in memory, mapped samples are paged in from their file
+    size_t getMemoryUsage() const;
+    
+    // gain ramps linearly from startGain to endGain across the frames read
+    void read(int channel, juce::int64 position, float* dest, int numToRead, float startGain = 1.0f, float endGain = 1.0f) const;
     
 private:
     double sampleRate;
-    int numSamples;
-    juce::AudioSampleBuffer tempBuffer;
-    juce::AudioSampleBuffer dataBuffer;
+    juce::int64 numSamples;
+    juce::int64 residentLength = 0;
+    int numChannels;
+    juce::File file;
+    Encoding encoding = Encoding::float32;
+    Quality quality = Quality::standard;
+    std::vector<juce::HeapBlock<char>> chunks;
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader;
+    std::unique_ptr<juce::MemoryMappedFile> mappedCache;
+    const float* cachedData = nullptr;
     
-    void resample(double sampleRatio);
+    char* getChunk(int channel, size_t chunkIndex) const;
+    void allocate(juce::int64 length);
+    void decode(juce::AudioFormatReader& reader, juce::int64 numSourceSamples, juce::int64 numAvailable, double destSampleRate, const DecodeOptions& options);
+    void write(juce::int64 position, const juce::AudioSampleBuffer& source, int numToWrite);
 };
@@ -2,14 +2,13 @@
 #include "Sound.h"
 
 
-void Sound::setSample(std::unique_ptr<Sample> value)
+void Sound::setSample(std::shared_ptr<const Sample> value)
 {
     sample = std::move(value);
     setPlaybackRange(playbackRange);
-    setGain(gain);
 }
 
-Sample* Sound::getSample() const
+const Sample* Sound::getSample() const
 {
     return sample.get();
 }
@@ -19,7 +18,7 @@ void Sound::setPlaybackRange(const PlaybackRange range)
     if (sample == nullptr)
         playbackRange = range;
     else
-        playbackRange = PlaybackRange(0, sample->getNumSamples()).constrainRange(range);
+        playbackRange = PlaybackRange(0.0, (double) sample->getNumSamples()).constrainRange(range);
 }
 
 Sound::PlaybackRange Sound::getPlaybackRange() const
@@ -36,16 +35,3 @@ bool Sound::getBypass() const
 {
     return bypass;
 }
-
-void Sound::setGain(float newGain)
-{
-    if (sample != nullptr)
-        sample->applyGain(newGain / gain);
-
-    gain = newGain;
-}
-
-float Sound::getGain() const
-{
-    return gain;
-}
@@ -8,8 +8,8 @@ class Sound final
 public:
     using PlaybackRange = juce::Range<double>;
     
-    void setSample(std::unique_ptr<Sample> value);
-    Sample* getSample() const;
+    void setSample(std::shared_ptr<const Sample> value);
+    const Sample* getSample() const;
     
     void setPlaybackRange(const PlaybackRange range);
     PlaybackRange getPlaybackRange() const;
@@ -17,12 +17,8 @@ public:
     void setBypass(bool isBypassed);
     bool getBypass() const;
     
-    void setGain(float newGain);
-    float getGain() const;
-    
 private:
-    std::unique_ptr<Sample> sample;
+    std::shared_ptr<const Sample> sample;
     PlaybackRange playbackRange;
     bool bypass = false;
-    float gain = 1.0f;
 };
@@ -0,0 +1,72 @@
+
+#include "WaveformPeaks.h"
+
+
+WaveformPeaks::WaveformPeaks(Level baseLevel)
+{
+    levels.front() = std::move(baseLevel);
+    finish();
+}
+
+void WaveformPeaks::append(const juce::AudioSampleBuffer& block, int startSample, int numSamples)
+{
+    for (int offset = startSample; offset < startSample + numSamples;)
+    {
+        auto numThisTime = juce::jmin(startSample + numSamples - offset, baseDecimation - numPending);
+        auto range = juce::FloatVectorOperations::findMinAndMax(block.getReadPointer(0, offset), numThisTime);
+        
+        for (int ch = 1; ch < block.getNumChannels(); ++ch)
+            range = range.getUnionWith(juce::FloatVectorOperations::findMinAndMax(block.getReadPointer(ch, offset), numThisTime));
+        
+        pending = numPending == 0 ? range : pending.getUnionWith(range);
+        numPending += numThisTime;
+        offset += numThisTime;
+        
+        if (numPending == baseDecimation)
+        {
+            levels.front().push_back(pending);
+            numPending = 0;
+        }
+    }
+}
+
+void WaveformPeaks::finish()
+{
+    if (numPending > 0)
+    {
+        levels.front().push_back(pending);
+        numPending = 0;
+    }
+    
+    levels.resize(1);
+    
+    while (levels.back().size() > 1)
+    {
+        const auto& source = levels.back();
+        Level level ((source.size() + 1) / 2);
+        
+        for (size_t i = 0; i < level.size(); ++i)
+            level[i] = 2 * i + 1 < source.size() ? source[2 * i].getUnionWith(source[2 * i + 1]) : source[2 * i];
+        
+        levels.push_back(std::move(level));
+    }
+}
+
+int WaveformPeaks::getNumLevels() const
+{
+    return (int) levels.size();
+}
+
+const WaveformPeaks::Level& WaveformPeaks::getLevel(int index) const
+{
+    return levels[(size_t) index];
+}
+
+const WaveformPeaks::Level& WaveformPeaks::getLevelFor(int numPoints) const
+{
+    for (auto level = levels.rbegin(); level != levels.rend(); ++level)
+        if ((int) level->size() >= numPoints)
+            return *level;
+    
+    return levels.front();
+}
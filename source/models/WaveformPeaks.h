@@ -0,0 +1,34 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+
+// Min/max summary of a sample across all of its channels. The base level holds one
+// range per baseDecimation source frames and every level above halves the previous
+// one, so drawing can pick the level closest to one range per pixel.
+class WaveformPeaks final
+{
+public:
+    using Level = std::vector<juce::Range<float>>;
+    
+    static constexpr int baseDecimation = 256;
+    
+    WaveformPeaks() = default;
+    explicit WaveformPeaks(Level baseLevel);
+    
+    // feed source frames in order, then build the upper levels with finish()
+    void append(const juce::AudioSampleBuffer& block, int startSample, int numSamples);
+    void finish();
+    
+    int getNumLevels() const;
+    const Level& getLevel(int index) const;
+    // the coarsest level that still has at least numPoints ranges
+    const Level& getLevelFor(int numPoints) const;
+    
+private:
+    std::vector<Level> levels = std::vector<Level>(1);
+    juce::Range<float> pending;
+    int numPending = 0;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveformPeaks)
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "parameters/GenericParameterListener.h"
+
+
+// Statically typed handle to a parameter owned by a ParameterRegistry.
+// T is bool, int, float or the enum a choice parameter maps its index to.
+template <typename T>
+struct ParameterHandle
+{
+    size_t index;
+};
+
+// Owns a processor's parameters in registration order. Handles index straight into the
+// registry and already know their parameter's type, so get() is a single atomic load with
+// no lookup, cast or allocation and can be called from the audio thread.
+class ParameterRegistry final
+{
+public:
+    template <typename T>
+    using Handle = ParameterHandle<T>;
+    
+    explicit ParameterRegistry(juce::AudioProcessor& proc) : processor(&proc) {}
+    
+    // Without a processor the parameters go into a layout for a juce::AudioProcessorValueTreeState,
+    // which then owns them; handles stay valid, so attachments and handles work side by side.
+    ParameterRegistry() = default;
+    juce::AudioProcessorValueTreeState::ParameterLayout takeLayout() { return std::move(layout); }
+    
+    Handle<bool> addBool(const std::string& ns, const juce::ParameterID& id, const juce::String& name, bool defaultValue)
+    {
+        return { add(ns, new juce::AudioParameterBool(id, name, defaultValue)) };
+    }
+    
+    Handle<int> addInt(const std::string& ns, const juce::ParameterID& id, const juce::String& name, int minValue, int maxValue, int defaultValue)
+    {
+        return { add(ns, new juce::AudioParameterInt(id, name, minValue, maxValue, defaultValue)) };
+    }
+    
+    Handle<float> addFloat(const std::string& ns, const juce::ParameterID& id, const juce::String& name, float minValue, float maxValue, float defaultValue)
+    {
+        return { add(ns, new juce::AudioParameterFloat(id, name, minValue, maxValue, defaultValue)) };
+    }
+    
+    Handle<float> addFloat(const std::string& ns, const juce::ParameterID& id, const juce::String& name, juce::NormalisableRange<float> range, float defaultValue, const juce::AudioParameterFloatAttributes& attributes = {})
+    {
+        return { add(ns, new juce::AudioParameterFloat(id, name, range, defaultValue, attributes)) };
+    }
+    
+    // labels is a null terminated list with one entry per enumerator, in order
+    template <typename Enum>
+    Handle<Enum> addChoice(const std::string& ns, const juce::ParameterID& id, const juce::String& name, const char* const* labels, Enum defaultValue, const juce::AudioParameterChoiceAttributes& attributes = {})
+    {
+        static_assert(std::is_enum_v<Enum>);
+        return { add(ns, new juce::AudioParameterChoice(id, name, juce::StringArray(labels), (int) defaultValue, attributes)) };
+    }
+    
+    void call(const std::string& ns, std::function<void()> callback)
+    {
+        callbacks[ns] = callback;
+    }
+    
+    template <typename T>
+    juce::RangedAudioParameter* raw(Handle<T> handle) const
+    {
+        return parameters[handle.index];
+    }
+    
+    juce::RangedAudioParameter* raw(const std::string& id) const
+    {
+        for (auto* parameter : parameters)
+            if (parameter->getParameterID().toStdString() == id)
+                return parameter;
+        
+        return nullptr;
+    }
+    
+    template <typename T>
+    T get(Handle<T> handle) const
+    {
+        auto* parameter = parameters[handle.index];
+        
+        if constexpr (std::is_same_v<T, bool>)
+            return static_cast<juce::AudioParameterBool*>(parameter)->get();
+        else if constexpr (std::is_same_v<T, int>)
+            return static_cast<juce::AudioParameterInt*>(parameter)->get();
+        else if constexpr (std::is_same_v<T, float>)
+            return static_cast<juce::AudioParameterFloat*>(parameter)->get();
+        else
+            return (T) static_cast<juce::AudioParameterChoice*>(parameter)->getIndex();
+    }
+    
+    template <typename T>
+    void set(Handle<T> handle, T value) const
+    {
+        auto* parameter = parameters[handle.index];
+        
+        if constexpr (std::is_same_v<T, bool>)
+            *static_cast<juce::AudioParameterBool*>(parameter) = value;
+        else if constexpr (std::is_same_v<T, int>)
+            *static_cast<juce::AudioParameterInt*>(parameter) = value;
+        else if constexpr (std::is_same_v<T, float>)
+            *static_cast<juce::AudioParameterFloat*>(parameter) = value;
+        else
+            *static_cast<juce::AudioParameterChoice*>(parameter) = (int) value;
+    }
+    
+    // state is stored as one child element per parameter, choices by label
+    template <typename T>
+    void read(Handle<T> handle, const juce::XmlElement& parent) const
+    {
+        auto* parameter = parameters[handle.index];
+        auto* child = parent.getChildByName(parameter->getParameterID());
+        if (child == nullptr)
+            return;
+        
+        auto value = child->getAllSubText();
+        if (value.isEmpty())
+            return;
+        
+        if constexpr (std::is_same_v<T, bool>)
+            set(handle, value == "true");
+        else if constexpr (std::is_same_v<T, int>)
+            set(handle, value.getIntValue());
+        else if constexpr (std::is_same_v<T, float>)
+            set(handle, value.getFloatValue());
+        else if (auto index = static_cast<juce::AudioParameterChoice*>(parameter)->choices.indexOf(value); index >= 0)
+            set(handle, (T) index);
+    }
+    
+    template <typename T>
+    void write(Handle<T> handle, juce::XmlElement& parent) const
+    {
+        auto* parameter = parameters[handle.index];
+        auto* child = parent.createNewChildElement(parameter->getParameterID());
+        
+        if constexpr (std::is_same_v<T, bool>)
+            child->addTextElement(get(handle) ? "true" : "false");
+        else if constexpr (std::is_same_v<T, int> || std::is_same_v<T, float>)
+            child->addTextElement(juce::String(get(handle)));
+        else
+            child->addTextElement(static_cast<juce::AudioParameterChoice*>(parameter)->getCurrentChoiceName());
+    }
+    
+private:
+    juce::AudioProcessor* processor = nullptr;
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    
+    std::vector<juce::RangedAudioParameter*> parameters;
+    std::map<std::string, std::function<void()>> callbacks;
+    std::vector<std::unique_ptr<GenericParameterListener>> listeners;
+    
+    size_t add(const std::string& ns, juce::RangedAudioParameter* parameter)
+    {
+        auto& listener = listeners.emplace_back(std::make_unique<GenericParameterListener>([ns, this]
+        {
+            if (auto callback = callbacks.find(ns); callback != callbacks.end())
+                callback->second();
+        }));
+        
+        parameter->addListener(listener.get());
+        
+        if (processor != nullptr)
+            processor->addParameter(parameter);
+        else
+            layout.add(std::unique_ptr<juce::RangedAudioParameter>(parameter));
+        
+        parameters.push_back(parameter);
+        return parameters.size() - 1;
+    }
+    
+    JUCE_DECLARE_NON_COPYABLE (ParameterRegistry)
+};
@@ -0,0 +1,87 @@
+
+#include "ParameterSnapshot.h"
+
+
+ParameterSnapshot::Handle ParameterSnapshot::add(const std::atomic<float>* value, double smoothingSeconds)
+{
+    jassert(value != nullptr);
+    
+    Entry entry;
+    entry.raw = value;
+    entry.smoothingSeconds = smoothingSeconds;
+    return addEntry(std::move(entry));
+}
+
+ParameterSnapshot::Handle ParameterSnapshot::add(const juce::AudioParameterFloat& parameter, double smoothingSeconds)
+{
+    Entry entry;
+    entry.parameter = &parameter;
+    entry.smoothingSeconds = smoothingSeconds;
+    return addEntry(std::move(entry));
+}
+
+ParameterSnapshot::Handle ParameterSnapshot::addEntry(Entry entry)
+{
+    auto value = entry.load();
+    entry.smoothed.setCurrentAndTargetValue(value);
+    entry.ramp = { value, value };
+    
+    entries.push_back(std::move(entry));
+    return (Handle) entries.size() - 1;
+}
+
+#pragma mark -
+
+void ParameterSnapshot::prepare(double sampleRate)
+{
+    for (auto& entry : entries)
+    {
+        auto value = entry.load();
+        
+        entry.smoothed.reset(sampleRate, entry.smoothingSeconds);
+        entry.smoothed.setCurrentAndTargetValue(value);
+        entry.ramp = { value, value };
+    }
+}
+
+void ParameterSnapshot::update(int numSamples)
+{
+    for (auto& entry : entries)
+    {
+        entry.smoothed.setTargetValue(entry.load());
+        entry.ramp.start = entry.smoothed.getCurrentValue();
+        entry.ramp.end = entry.smoothed.isSmoothing() ? entry.smoothed.skip(numSamples) : entry.ramp.start;
+    }
+}
+
+float ParameterSnapshot::get(Handle handle) const
+{
+    return entries[(size_t) handle].ramp.end;
+}
+
+bool ParameterSnapshot::isOn(Handle handle) const
+{
+    return get(handle) > 0.5f;
+}
+
+ParameterSnapshot::Ramp ParameterSnapshot::getRamp(Handle handle) const
+{
+    return entries[(size_t) handle].ramp;
+}
+
+void ParameterSnapshot::applyGain(Handle handle, juce::AudioBuffer<float>& buffer, int startSample, int numSamples) const
+{
+    auto ramp = getRamp(handle);
+    
+    if (ramp.isConstant())
+        buffer.applyGain(startSample, numSamples, ramp.end);
+    else
+        buffer.applyGainRamp(startSample, numSamples, ramp.start, ramp.end);
+}
+
+#pragma mark -
+
+float ParameterSnapshot::Entry::load() const
+{
+    return raw != nullptr ? raw->load(std::memory_order_relaxed) : parameter->get();
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+
+// Per-block view of a processor's parameters for the audio thread.
+// Parameters are resolved to their atomic values once on the message thread, then
+// update() loads each of them once per block and advances the smoothed ones, so
+// rendering code never looks parameters up by name or reads them per sample.
+class ParameterSnapshot final
+{
+public:
+    using Handle = int;
+    
+    struct Ramp
+    {
+        float start;
+        float end;
+        
+        bool isConstant() const { return juce::approximatelyEqual(start, end); }
+    };
+    
+    // message thread, before the processor is prepared
+    Handle add(const std::atomic<float>* value, double smoothingSeconds = 0.0);
+    Handle add(const juce::AudioParameterFloat& parameter, double smoothingSeconds = 0.0);
+    
+    // audio thread
+    void prepare(double sampleRate);
+    void update(int numSamples);
+    
+    float get(Handle handle) const;
+    bool isOn(Handle handle) const;
+    Ramp getRamp(Handle handle) const;
+    
+    // multiplies every channel by the parameter, ramping when it is still smoothing
+    void applyGain(Handle handle, juce::AudioBuffer<float>& buffer, int startSample, int numSamples) const;
+    
+private:
+    struct Entry
+    {
+        const std::atomic<float>* raw = nullptr;
+        const juce::AudioParameterFloat* parameter = nullptr;
+        double smoothingSeconds = 0.0;
+        juce::SmoothedValue<float> smoothed;
+        Ramp ramp { 0.0f, 0.0f };
+        
+        float load() const;
+    };
+    
+    std::vector<Entry> entries;
+    
+    Handle addEntry(Entry entry);
+};
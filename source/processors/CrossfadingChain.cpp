@@ -0,0 +1,210 @@
+#include "CrossfadingChain.h"
+#include <algorithm>
+
+
+bool CrossfadingChain::Topology::contains(const juce::AudioProcessor* effect) const
+{
+    return std::find(effects.begin(), effects.begin() + numEffects, effect) != effects.begin() + numEffects;
+}
+
+#pragma mark -
+
+CrossfadingChain::CrossfadingChain()
+{
+}
+
+CrossfadingChain::~CrossfadingChain()
+{
+    stopTimer();
+}
+
+#pragma mark -
+
+void CrossfadingChain::prepare(int channels, double rate, int maximumBlockSize)
+{
+    numChannels = channels;
+    sampleRate = rate;
+    blockSize = maximumBlockSize;
+    
+    dry.setSize(numChannels, blockSize);
+    ramp.malloc((size_t) blockSize);
+    
+    for (auto& effect : effects)
+        prepareEffect(*effect);
+    
+    for (auto& slot : slots)
+        slot.mix.reset(sampleRate, fadeSeconds);
+}
+
+void CrossfadingChain::release()
+{
+    for (auto& effect : effects)
+        effect->releaseResources();
+}
+
+bool CrossfadingChain::add(std::unique_ptr<juce::AudioProcessor> effect, int position)
+{
+    if (effect == nullptr || (int) effects.size() == maxEffects || (int) (effects.size() + removed.size()) == maxSlots)
+        return false;
+    
+    if (sampleRate > 0.0)
+        prepareEffect(*effect);
+    
+    if (position < 0 || position > (int) effects.size())
+        position = (int) effects.size();
+    
+    effects.insert(effects.begin() + position, std::move(effect));
+    publish();
+    return true;
+}
+
+void CrossfadingChain::remove(juce::AudioProcessor* effect)
+{
+    auto found = std::find_if(effects.begin(), effects.end(), [effect] (auto& e) { return e.get() == effect; });
+    if (found == effects.end())
+        return;
+    
+    // freed once the audio thread has faded it out of the topology that drops it
+    removed.push_back({ std::move(*found), generation + 1 });
+    effects.erase(found);
+    publish();
+}
+
+#pragma mark -
+
+void CrossfadingChain::process(juce::AudioBuffer<float>& audioBuffer, juce::MidiBuffer& midiBuffer)
+{
+    if (auto* topology = topologies.acquire(); topology != nullptr && topology->generation != adoptedGeneration)
+        adopt(*topology);
+    
+    for (int i = 0; i < numSlots; ++i)
+        processSlot(slots[(size_t) i], audioBuffer, midiBuffer);
+    
+    int kept = 0;
+    bool isFadingOut = false;
+    
+    for (int i = 0; i < numSlots; ++i)
+    {
+        auto& slot = slots[(size_t) i];
+        auto isLeaving = slot.mix.getTargetValue() <= 0.0f;
+        
+        if (isLeaving && !slot.mix.isSmoothing())
+            continue;
+        
+        isFadingOut = isFadingOut || isLeaving;
+        slots[(size_t) kept++] = slot;
+    }
+    
+    numSlots = kept;
+    
+    if (!isFadingOut)
+        settledGeneration.store(adoptedGeneration, std::memory_order_release);
+}
+
+#pragma mark -
+
+void CrossfadingChain::prepareEffect(juce::AudioProcessor& effect) const
+{
+    effect.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+    effect.enableAllBuses();
+    effect.prepareToPlay(sampleRate, blockSize);
+}
+
+void CrossfadingChain::publish()
+{
+    auto topology = std::make_unique<Topology>();
+    
+    for (auto& effect : effects)
+        topology->effects[(size_t) topology->numEffects++] = effect.get();
+    
+    topology->generation = ++generation;
+    topologies.publish(std::move(topology));
+    
+    startTimerHz(10);
+}
+
+void CrossfadingChain::adopt(const Topology& topology)
+{
+    std::array<Slot, maxSlots> next;
+    int numNext = 0;
+    
+    for (int i = 0; i < topology.numEffects; ++i)
+    {
+        auto& slot = next[(size_t) numNext++];
+        slot.effect = topology.effects[(size_t) i];
+        
+        auto existing = std::find_if(slots.begin(), slots.begin() + numSlots, [&slot] (const Slot& s) { return s.effect == slot.effect; });
+        if (existing != slots.begin() + numSlots)
+        {
+            slot.mix = existing->mix;
+        }
+        else
+        {
+            slot.mix.reset(sampleRate, fadeSeconds);
+            slot.mix.setCurrentAndTargetValue(0.0f);
+        }
+        
+        slot.mix.setTargetValue(1.0f);
+    }
+    
+    // an effect on its way out keeps its place in the chain until it has faded
+    for (int i = 0; i < numSlots; ++i)
+    {
+        auto& slot = slots[(size_t) i];
+        if (topology.contains(slot.effect) || numNext == maxSlots)
+            continue;
+        
+        auto position = juce::jmin(i, numNext);
+        std::move_backward(next.begin() + position, next.begin() + numNext, next.begin() + numNext + 1);
+        next[(size_t) position] = slot;
+        next[(size_t) position].mix.setTargetValue(0.0f);
+        ++numNext;
+    }
+    
+    slots = next;
+    numSlots = numNext;
+    adoptedGeneration = topology.generation;
+}
+
+void CrossfadingChain::processSlot(Slot& slot, juce::AudioBuffer<float>& audioBuffer, juce::MidiBuffer& midiBuffer)
+{
+    if (!slot.mix.isSmoothing())
+    {
+        slot.effect->processBlock(audioBuffer, midiBuffer);
+        return;
+    }
+    
+    auto numSamples = audioBuffer.getNumSamples();
+    auto channels = juce::jmin(audioBuffer.getNumChannels(), dry.getNumChannels());
+    jassert (numSamples <= dry.getNumSamples());
+    
+    for (int ch = 0; ch < channels; ++ch)
+        dry.copyFrom(ch, 0, audioBuffer, ch, 0, numSamples);
+    
+    slot.effect->processBlock(audioBuffer, midiBuffer);
+    
+    for (int i = 0; i < numSamples; ++i)
+        ramp[i] = slot.mix.getNextValue();
+    
+    // dry + (wet - dry) * mix
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        auto* out = audioBuffer.getWritePointer(ch);
+        auto* in = dry.getReadPointer(ch);
+        
+        juce::FloatVectorOperations::subtract(out, in, numSamples);
+        juce::FloatVectorOperations::multiply(out, ramp.get(), numSamples);
+        juce::FloatVectorOperations::add(out, in, numSamples);
+    }
+}
+
+void CrossfadingChain::timerCallback()
+{
+    topologies.collect();
+    
+    auto settled = settledGeneration.load(std::memory_order_acquire);
+    removed.erase(std::remove_if(removed.begin(), removed.end(), [settled] (auto& r) { return r.generation <= settled; }), removed.end());
+    
+    if (removed.empty() && !topologies.hasPending())
+        stopTimer();
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "utils/AtomicHandoff.h"
+
+
+// Effects run one after another over the sampler mix. Edits are made and prepared on the message
+// thread and handed to the audio thread as a whole new topology, so nothing is rebuilt while
+// rendering. An effect that joins fades its output in over the dry signal and one that leaves
+// fades back out before it is dropped, so an edit never clicks.
+class CrossfadingChain final : private juce::Timer
+{
+public:
+    static constexpr int maxEffects = 8;
+    static constexpr double fadeSeconds = 0.02;
+    
+    CrossfadingChain();
+    ~CrossfadingChain() override;
+    
+    // message thread, while the audio thread isn't running
+    void prepare(int numChannels, double sampleRate, int maximumBlockSize);
+    void release();
+    
+    // message thread: the effect is prepared here, returns false if the chain is full
+    bool add(std::unique_ptr<juce::AudioProcessor> effect, int position = -1);
+    void remove(juce::AudioProcessor* effect);
+    
+    int size() const { return (int) effects.size(); }
+    juce::AudioProcessor* get(int index) const { return effects[(size_t) index].get(); }
+    
+    // audio thread
+    void process(juce::AudioBuffer<float>& audioBuffer, juce::MidiBuffer& midiBuffer);
+    
+private:
+    // room for a full chain plus as many effects again that were removed and are still fading out
+    static constexpr int maxSlots = maxEffects * 2;
+    
+    struct Topology
+    {
+        std::array<juce::AudioProcessor*, maxEffects> effects {};
+        int numEffects = 0;
+        int generation = 0;
+        
+        bool contains(const juce::AudioProcessor* effect) const;
+    };
+    
+    struct Slot
+    {
+        juce::AudioProcessor* effect = nullptr;
+        juce::SmoothedValue<float> mix;
+    };
+    
+    struct RemovedEffect
+    {
+        std::unique_ptr<juce::AudioProcessor> effect;
+        int generation = 0;
+    };
+    
+    // message thread
+    std::vector<std::unique_ptr<juce::AudioProcessor>> effects;
+    std::vector<RemovedEffect> removed;
+    int generation = 0;
+    int numChannels = 2;
+    double sampleRate = 0.0;
+    int blockSize = 0;
+    
+    AtomicHandoff<Topology> topologies;
+    std::atomic<int> settledGeneration { 0 };
+    
+    // audio thread
+    std::array<Slot, maxSlots> slots;
+    int numSlots = 0;
+    int adoptedGeneration = 0;
+    juce::AudioBuffer<float> dry;
+    juce::HeapBlock<float> ramp;
+    
+    void prepareEffect(juce::AudioProcessor& effect) const;
+    void publish();
+    void adopt(const Topology& topology);
+    void processSlot(Slot& slot, juce::AudioBuffer<float>& audioBuffer, juce::MidiBuffer& midiBuffer);
+    void timerCallback() override;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CrossfadingChain)
+};
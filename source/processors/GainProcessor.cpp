@@ -4,14 +4,21 @@
 
 GainProcessor::GainProcessor()
     : ProcessorBase(),
-    gain(new juce::AudioParameterFloat({ "gain", 1 }, "Gain", 0.0f, 2.0f, 1.0f))
+    gain(new juce::AudioParameterFloat({ "gain", 1 }, "Gain", 0.0f, 2.0f, 1.0f)),
+    gainHandle(snapshot.add(*gain, 0.02))
 {
     addParameter(gain);
 }
 
+void GainProcessor::prepareToPlay(double sampleRate, int)
+{
+    snapshot.prepare(sampleRate);
+}
+
 void GainProcessor::processBlock(juce::AudioBuffer<float> &audioBuffer, juce::MidiBuffer &)
 {
-    audioBuffer.applyGain(*gain);
+    snapshot.update(audioBuffer.getNumSamples());
+    snapshot.applyGain(gainHandle, audioBuffer, 0, audioBuffer.getNumSamples());
 }
 
 void GainProcessor::reset()
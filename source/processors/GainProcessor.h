@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ProcessorBase.h"
+#include "parameters/ParameterSnapshot.h"
 
 
 class GainProcessor : public ProcessorBase
@@ -8,6 +9,7 @@ class GainProcessor : public ProcessorBase
 public:
     GainProcessor();
     
+    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
     void processBlock (juce::AudioBuffer<float>& audioBuffer, juce::MidiBuffer&) override;
     void reset() override;
     
@@ -15,5 +17,7 @@ public:
 
 private:
     juce::AudioParameterFloat* gain;
+    ParameterSnapshot snapshot;
+    const ParameterSnapshot::Handle gainHandle;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GainProcessor)
 };
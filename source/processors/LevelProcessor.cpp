@@ -4,16 +4,21 @@
 
 LevelProcessor::LevelProcessor()
     : ProcessorBase(),
-    level(new juce::AudioParameterFloat({ "level", 1 }, "Level", 0.0f, 2.0f, 1.0f))
+    level(new juce::AudioParameterFloat({ "level", 1 }, "Level", 0.0f, 2.0f, 1.0f)),
+    levelHandle(snapshot.add(*level, 0.02))
 {
     addParameter(level);
 }
 
+void LevelProcessor::prepareToPlay(double sampleRate, int)
+{
+    snapshot.prepare(sampleRate);
+}
+
 void LevelProcessor::processBlock(juce::AudioBuffer<float> &audioBuffer, juce::MidiBuffer &)
 {
-    for (int ch = 0; ch < audioBuffer.getNumChannels(); ++ch)
-        for (int sample = 0; sample < audioBuffer.getNumSamples(); ++sample)
-            audioBuffer.setSample(ch, sample, audioBuffer.getSample(ch, sample) * *level);
+    snapshot.update(audioBuffer.getNumSamples());
+    snapshot.applyGain(levelHandle, audioBuffer, 0, audioBuffer.getNumSamples());
 }
 
 void LevelProcessor::reset()
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ProcessorBase.h"
+#include "parameters/ParameterSnapshot.h"
 
 
 class LevelProcessor : public ProcessorBase
@@ -8,6 +9,7 @@ class LevelProcessor : public ProcessorBase
 public:
     LevelProcessor();
     
+    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
     void processBlock (juce::AudioBuffer<float>& audioBuffer, juce::MidiBuffer&) override;
     void reset() override;
     
@@ -15,5 +17,7 @@ public:
     
 private:
     juce::AudioParameterFloat* level;
+    ParameterSnapshot snapshot;
+    const ParameterSnapshot::Handle levelHandle;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelProcessor)
 };
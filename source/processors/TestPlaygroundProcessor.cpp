@@ -47,12 +47,17 @@ void TestPlaygroundProcessor::processBlock(juce::AudioBuffer<float> & audioBuffe
     // Accessing the parameter values of pitch wheel, pitch offset and pitch randomisation
     // auto pitchValue = *pitchOffset + *pitchWheel + juce::Random::getSystemRandom().nextFloat() * *randomPitchRange;
 
-    // Render next block
-    mSampler.renderNextBlock(audioBuffer, midiBuffer, 0, audioBuffer.getNumSamples());
+    // Render up to each MIDI event and handle it at its own sample offset, so notes land on
+    // the frame they were played on instead of a block late. The synth itself gets no MIDI,
+    // every note goes through the random file picking below.
+    auto position = 0;
 
-    // Iterate over incoming MIDI messages
     for (const auto metadata : midiBuffer)
     {
+        auto eventPosition = juce::jlimit(position, audioBuffer.getNumSamples(), metadata.samplePosition);
+        mSampler.renderNextBlock(audioBuffer, noMidi, position, eventPosition - position);
+        position = eventPosition;
+
         const juce::MidiMessage& midiEvent = metadata.getMessage();
         
         if (midiEvent.isNoteOn())
@@ -68,8 +73,14 @@ void TestPlaygroundProcessor::processBlock(juce::AudioBuffer<float> & audioBuffe
             mSampler.allNotesOff(midiEvent.getChannel(), true);
             setCurrentlyPlayingFileIndex(-1);
         }
+        else if (midiEvent.isController())
+        {
+            mSampler.handleController(midiEvent.getChannel(), midiEvent.getControllerNumber(), midiEvent.getControllerValue());
+        }
     }
 
+    mSampler.renderNextBlock(audioBuffer, noMidi, position, audioBuffer.getNumSamples() - position);
+
     // Remove processed MIDI messages
     midiBuffer.clear();
 
@@ -16,6 +16,7 @@ public:
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
     void processBlock (juce::AudioBuffer<float>& audioBuffer, juce::MidiBuffer& midiBuffer) override;
+    bool acceptsMidi() const override { return true; }
 
     // Sampler
     juce::Synthesiser mSampler;
@@ -51,5 +52,8 @@ public:
     //    juce::AudioParameterFloat* randomPitchRange;
 
 private:
+    // handed to the synth while rendering, notes are triggered by processBlock itself
+    juce::MidiBuffer noMidi;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TestPlaygroundProcessor)
 };
@@ -0,0 +1,149 @@
+#include "PlaylistGenerator.h"
+#include <algorithm>
+#include <numeric>
+
+
+PlaylistGenerator::PlaylistGenerator(bool runsOwnThread)
+{
+    if (!runsOwnThread)
+        return;
+    
+    thread.addTimeSliceClient(this);
+    thread.startThread(juce::Thread::Priority::low);
+}
+
+PlaylistGenerator::~PlaylistGenerator()
+{
+    thread.removeTimeSliceClient(this);
+    thread.stopThread(1000);
+}
+
+#pragma mark -
+
+void PlaylistGenerator::restart(int size, PlaybackOrder::Order newOrder, int firstPosition)
+{
+    requestedSize.store(size, std::memory_order_relaxed);
+    requestedOrder.store(newOrder, std::memory_order_relaxed);
+    requestedPosition.store(firstPosition, std::memory_order_relaxed);
+    requestedGeneration.fetch_add(1, std::memory_order_release);
+    
+    thread.moveToFrontOfQueue(this);
+}
+
+PlaylistGenerator::Entry PlaylistGenerator::pop()
+{
+    // until the generator has taken up the latest restart everything queued is stale
+    if (adoptedGeneration.load(std::memory_order_acquire) != requestedGeneration.load(std::memory_order_acquire))
+        return {};
+    
+    auto numStale = (int) juce::jlimit((juce::int64) 0, (juce::int64) fifo.getNumReady(), staleUntil.load(std::memory_order_relaxed) - numRead);
+    if (numStale > 0)
+    {
+        fifo.finishedRead(numStale);
+        numRead += numStale;
+    }
+    
+    if (fifo.getNumReady() == 0)
+        return {};
+    
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(1, start1, size1, start2, size2);
+    auto entry = queue[(size_t) start1];
+    fifo.finishedRead(1);
+    ++numRead;
+    
+    return entry;
+}
+
+void PlaylistGenerator::generate()
+{
+    auto wanted = requestedGeneration.load(std::memory_order_acquire);
+    
+    if (wanted != generation)
+    {
+        generation = wanted;
+        numSamples = requestedSize.load(std::memory_order_relaxed);
+        order = requestedOrder.load(std::memory_order_relaxed);
+        position = juce::jlimit(0, juce::jmax(0, numSamples - 1), requestedPosition.load(std::memory_order_relaxed));
+        lastIndex = -1;
+        
+        pass.resize((size_t) numSamples);
+        shufflePass();
+        
+        staleUntil.store(numWritten, std::memory_order_relaxed);
+        adoptedGeneration.store(generation, std::memory_order_release);
+    }
+    
+    if (numSamples == 0)
+        return;
+    
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(fifo.getFreeSpace(), start1, size1, start2, size2);
+    
+    for (int i = 0; i < size1; ++i)
+        queue[(size_t) (start1 + i)] = next();
+    
+    for (int i = 0; i < size2; ++i)
+        queue[(size_t) (start2 + i)] = next();
+    
+    fifo.finishedWrite(size1 + size2);
+    numWritten += size1 + size2;
+}
+
+#pragma mark -
+
+int PlaylistGenerator::useTimeSlice()
+{
+    generate();
+    return numSamples == 0 ? 50 : 20;
+}
+
+PlaylistGenerator::Entry PlaylistGenerator::next()
+{
+    Entry entry;
+    entry.position = position;
+    
+    switch (order)
+    {
+        case PlaybackOrder::Order::ordinal:
+            entry.index = position;
+            break;
+        
+        case PlaybackOrder::Order::shuffle:
+            entry.index = pass[(size_t) position];
+            break;
+        
+        case PlaybackOrder::Order::random:
+        {
+            // never the same sample twice in a row
+            auto numChoices = lastIndex == -1 || numSamples < 2 ? numSamples : numSamples - 1;
+            entry.index = std::uniform_int_distribution<int> (0, numChoices - 1)(randomEngine);
+            if (numChoices < numSamples && entry.index >= lastIndex)
+                ++entry.index;
+            break;
+        }
+    }
+    
+    lastIndex = entry.index;
+    
+    if (++position >= numSamples)
+    {
+        position = 0;
+        shufflePass();
+    }
+    
+    return entry;
+}
+
+void PlaylistGenerator::shufflePass()
+{
+    if (order != PlaybackOrder::Order::shuffle)
+        return;
+    
+    std::iota(pass.begin(), pass.end(), 0);
+    std::shuffle(pass.begin(), pass.end(), randomEngine);
+    
+    // a new pass doesn't open with the sample that closed the last one
+    if (pass.size() > 1 && pass.front() == lastIndex)
+        std::swap(pass.front(), pass.back());
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <random>
+#include "SamplerUtils.h"
+
+
+// Works out the upcoming playlist on a background thread and queues it for the audio thread, so
+// shuffling and random picks never run while rendering. A playlist is a series of passes, each as
+// long as the sample set; a shuffle pass plays every sample once, a random pass picks independently.
+// After a restart the generator marks how much of the queue is stale, and the audio thread skips
+// all of it in one step.
+class PlaylistGenerator final : private juce::TimeSliceClient
+{
+public:
+    static constexpr int queueLength = 256;
+    
+    struct Entry
+    {
+        int index = -1;
+        int position = 0;   // within the pass, 0 when the playlist wraps
+    };
+    
+    // without its own thread the queue is only filled by calling generate()
+    explicit PlaylistGenerator(bool runsOwnThread = true);
+    ~PlaylistGenerator() override;
+    
+    // message thread: drops whatever is queued and starts over, the first pass from firstPosition
+    void restart(int numSamples, PlaybackOrder::Order order, int firstPosition = 0);
+    
+    // audio thread: never blocks or allocates, returns an index of -1 when nothing is queued yet
+    Entry pop();
+    
+    // the generator's own thread, or the one thread driving a generator that has none: takes up the
+    // latest restart and tops the queue up
+    void generate();
+    
+private:
+    juce::TimeSliceThread thread { "Playlist generator" };
+    juce::AbstractFifo fifo { queueLength };
+    std::array<Entry, (size_t) queueLength> queue;
+    
+    std::atomic<int> requestedSize { 0 };
+    std::atomic<PlaybackOrder::Order> requestedOrder { PlaybackOrder::Order::ordinal };
+    std::atomic<int> requestedPosition { 0 };
+    std::atomic<int> requestedGeneration { 0 };
+    
+    // entries written before the generator took up its current generation are stale
+    std::atomic<int> adoptedGeneration { 0 };
+    std::atomic<juce::int64> staleUntil { 0 };
+    
+    // owned by the audio thread
+    juce::int64 numRead = 0;
+    
+    // owned by the generating thread
+    juce::int64 numWritten = 0;
+    int generation = 0;
+    int numSamples = 0;
+    PlaybackOrder::Order order = PlaybackOrder::Order::ordinal;
+    int position = 0;
+    int lastIndex = -1;
+    std::vector<int> pass;
+    std::mt19937 randomEngine { std::random_device()() };
+    
+    int useTimeSlice() override;
+    Entry next();
+    void shufflePass();
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PlaylistGenerator)
+};
@@ -0,0 +1,198 @@
+
+#include "SampleCache.h"
+
+
+static constexpr char cacheMagic[4] = { 'B', 'X', 'S', 'C' };
+static constexpr juce::uint32 cacheVersion = 2;
+
+SampleCache::SampleCache()
+    : SampleCache(juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("Banditex").getChildFile("SampleCache"))
+{
+}
+
+SampleCache::SampleCache(const juce::File& cacheDirectory, juce::int64 maximumBytes)
+    : directory(cacheDirectory), maxBytes(maximumBytes)
+{
+    directory.createDirectory();
+}
+
+#pragma mark -
+
+std::optional<juce::uint64> SampleCache::hashContents(const juce::File& file)
+{
+    juce::FileInputStream stream (file);
+    if (!stream.openedOk())
+        return std::nullopt;
+    
+    const int blockSize = 1 << 16;
+    juce::HeapBlock<juce::uint8> block (blockSize);
+    
+    juce::uint64 hash = 14695981039346656037ull;
+    
+    for (auto numRead = stream.read(block, blockSize); numRead > 0; numRead = stream.read(block, blockSize))
+        for (int i = 0; i < numRead; ++i)
+            hash = (hash ^ block[i]) * 1099511628211ull;
+    
+    return hash;
+}
+
+std::optional<juce::uint64> SampleCache::getContentHash(const juce::File& file) const
+{
+    auto size = file.getSize();
+    auto lastModified = file.getLastModificationTime().toMilliseconds();
+    auto hashFile = getHashFileFor(file);
+    
+    juce::MemoryBlock stored;
+    if (hashFile.loadFileAsData(stored) && stored.getSize() == sizeof(HashEntry))
+    {
+        HashEntry entry;
+        std::memcpy(&entry, stored.getData(), sizeof(HashEntry));
+        
+        if (entry.size == size && entry.lastModified == lastModified)
+            return entry.contentHash;
+    }
+    
+    auto contentHash = hashContents(file);
+    if (!contentHash.has_value())
+        return std::nullopt;
+    
+    HashEntry entry { size, lastModified, *contentHash };
+    
+    juce::TemporaryFile temp (hashFile);
+    if (temp.getFile().replaceWithData(&entry, sizeof(HashEntry)))
+        temp.overwriteTargetFileWithTemporary();
+    
+    return contentHash;
+}
+
+std::shared_ptr<const Sample> SampleCache::load(const Key& key, std::shared_ptr<const WaveformPeaks>& peaks) const
+{
+    auto file = getFileFor(key);
+    if (!file.existsAsFile())
+        return nullptr;
+    
+    // the modification time doubles as the last use, which is what prune goes by
+    file.setLastModificationTime(juce::Time::getCurrentTime());
+    
+    auto mapping = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    if (mapping->getData() == nullptr || mapping->getSize() < sizeof(Header))
+        return nullptr;
+    
+    Header header;
+    std::memcpy(&header, mapping->getData(), sizeof(Header));
+    
+    if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != cacheVersion)
+        return nullptr;
+    
+    auto numDataSamples = (size_t) header.numChannels * (size_t) header.numSamples;
+    if (mapping->getSize() != sizeof(Header) + (numDataSamples + 2 * (size_t) header.numPeaks) * sizeof(float))
+        return nullptr;
+    
+    auto* peaksData = static_cast<const float*>(juce::addBytesToPointer(mapping->getData(), sizeof(Header))) + numDataSamples;
+    WaveformPeaks::Level baseLevel ((size_t) header.numPeaks);
+    
+    for (size_t i = 0; i < baseLevel.size(); ++i)
+        baseLevel[i] = { peaksData[2 * i], peaksData[2 * i + 1] };
+    
+    peaks = std::make_shared<const WaveformPeaks>(std::move(baseLevel));
+    
+    try
+    {
+        return std::make_shared<const Sample>(std::move(mapping), sizeof(Header), (int) header.numChannels, header.numSamples, header.sampleRate);
+    }
+    catch (const std::exception& exception)
+    {
+        juce::ignoreUnused(exception);
+        DBG(exception.what());
+        return nullptr;
+    }
+}
+
+void SampleCache::store(const Key& key, const Sample& sample, const WaveformPeaks& peaks) const
+{
+    juce::TemporaryFile temp (getFileFor(key));
+    
+    {
+        juce::FileOutputStream stream (temp.getFile());
+        if (!stream.openedOk())
+            return;
+        
+        Header header {};
+        std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+        header.version = cacheVersion;
+        header.numChannels = (juce::uint32) sample.getNumChannels();
+        header.numSamples = sample.getNumSamples();
+        header.numPeaks = (juce::int64) peaks.getLevel(0).size();
+        header.sampleRate = sample.getSampleRate();
+        
+        stream.write(&header, sizeof(Header));
+        
+        juce::HeapBlock<float> block (Sample::chunkLength);
+        
+        for (int ch = 0; ch < sample.getNumChannels(); ++ch)
+        {
+            for (juce::int64 position = 0; position < sample.getNumSamples(); position += Sample::chunkLength)
+            {
+                auto length = (int) juce::jmin((juce::int64) Sample::chunkLength, sample.getNumSamples() - position);
+                sample.read(ch, position, block, length);
+                stream.write(block, (size_t) length * sizeof(float));
+            }
+        }
+        
+        for (auto& range : peaks.getLevel(0))
+        {
+            stream.writeFloat(range.getStart());
+            stream.writeFloat(range.getEnd());
+        }
+        
+        stream.flush();
+        if (stream.getStatus().failed())
+            return;
+    }
+    
+    if (temp.overwriteTargetFileWithTemporary())
+        prune(getFileFor(key));
+}
+
+#pragma mark -
+
+juce::File SampleCache::getFileFor(const Key& key) const
+{
+    auto name = juce::String::toHexString((juce::int64) key.contentHash)
+        + "-" + juce::String(juce::roundToInt(key.sourceSampleRate))
+        + "-" + juce::String(juce::roundToInt(key.targetSampleRate))
+        + "-q" + juce::String((int) key.quality);
+    
+    return directory.getChildFile(name).withFileExtension("bxs");
+}
+
+juce::File SampleCache::getHashFileFor(const juce::File& file) const
+{
+    auto name = juce::String::toHexString(file.getFullPathName().hashCode64());
+    return directory.getChildFile(name).withFileExtension("bxh");
+}
+
+void SampleCache::prune(const juce::File& keep) const
+{
+    auto entries = directory.findChildFiles(juce::File::findFiles, false, "*.bxs");
+    
+    std::sort(entries.begin(), entries.end(), [] (const juce::File& a, const juce::File& b)
+    {
+        return a.getLastModificationTime() > b.getLastModificationTime();
+    });
+    
+    auto total = keep.getSize();
+    
+    for (auto& entry : entries)
+    {
+        if (entry == keep)
+            continue;
+        
+        auto size = entry.getSize();
+        total += size;
+        
+        // entries still mapped by a loaded sample stay readable, the mapping outlives the name
+        if (total > maxBytes && entry.deleteFile())
+            total -= size;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "models/Sample.h"
+#include "models/WaveformPeaks.h"
+
+
+// Content addressed on-disk cache of decoded and resampled samples.
+// Entries are planar float data followed by the base level of the waveform peaks,
+// laid out so that a warm load is a single memory mapping with no decoding or resampling.
+// The content hash of each source file is remembered next to its size and modification
+// time, so a file is only read in full again once either of them changes.
+// Entries are kept within a byte budget, the least recently used going first.
+class SampleCache final
+{
+public:
+    struct Key
+    {
+        juce::uint64 contentHash;
+        double sourceSampleRate;
+        double targetSampleRate;
+        Sample::Quality quality;
+    };
+    
+    static constexpr juce::int64 defaultMaxBytes = (juce::int64) 4 << 30;
+    
+    SampleCache();
+    explicit SampleCache(const juce::File& directory, juce::int64 maxBytes = defaultMaxBytes);
+    
+    // 64-bit FNV-1a over the file contents
+    static std::optional<juce::uint64> hashContents(const juce::File& file);
+    
+    // the remembered hash while the file's size and modification time still match, else hashContents
+    std::optional<juce::uint64> getContentHash(const juce::File& file) const;
+    
+    std::shared_ptr<const Sample> load(const Key& key, std::shared_ptr<const WaveformPeaks>& peaks) const;
+    void store(const Key& key, const Sample& sample, const WaveformPeaks& peaks) const;
+    
+private:
+    struct Header
+    {
+        char magic[4];
+        juce::uint32 version;
+        juce::uint32 numChannels;
+        juce::uint32 reserved;
+        juce::int64 numSamples;
+        juce::int64 numPeaks;
+        double sampleRate;
+        char padding[24];
+    };
+    
+    static_assert(sizeof(Header) == 64);
+    
+    struct HashEntry
+    {
+        juce::int64 size;
+        juce::int64 lastModified;
+        juce::uint64 contentHash;
+    };
+    
+    const juce::File directory;
+    const juce::int64 maxBytes;
+    
+    juce::File getFileFor(const Key& key) const;
+    juce::File getHashFileFor(const juce::File& file) const;
+    
+    // deletes the oldest entries by modification time until the rest fit the budget, keeping the given one
+    void prune(const juce::File& keep) const;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleCache)
+};
@@ -0,0 +1,170 @@
+
+#include "SampleEncoding.h"
+
+#if defined (__SSE2__) || defined (_M_X64) || defined (_M_AMD64)
+ #include <immintrin.h>
+ #define BANDITEX_SSE2 1
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+ #include <arm_neon.h>
+ #define BANDITEX_NEON 1
+#endif
+
+
+static constexpr float int16Scale = 32767.0f;
+static constexpr float int24Scale = 8388607.0f;
+
+static void decodeInt16(const juce::int16* source, float* dest, int numSamples, float gain)
+{
+    const float scale = gain / int16Scale;
+    int i = 0;
+   
+   #if BANDITEX_SSE2
+    auto multiplier = _mm_set1_ps(scale);
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        auto values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        auto low = _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16);
+        auto high = _mm_srai_epi32(_mm_unpackhi_epi16(values, values), 16);
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(low), multiplier));
+        _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), multiplier));
+    }
+   #elif BANDITEX_NEON
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        auto values = vld1q_s16(source + i);
+        vst1q_f32(dest + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(values))), scale));
+        vst1q_f32(dest + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(values))), scale));
+    }
+   #endif
+    
+    for (; i < numSamples; ++i)
+        dest[i] = (float) source[i] * scale;
+}
+
+#if BANDITEX_SSE2
+ #if JUCE_GCC || JUCE_CLANG
+  #define BANDITEX_TARGET_SSSE3 __attribute__ ((target ("ssse3")))
+ #else
+  #define BANDITEX_TARGET_SSSE3
+ #endif
+
+// built for SSSE3 whatever the build targets, and only called once the CPU is known to have it;
+// returns how many frames it decoded
+BANDITEX_TARGET_SSSE3 static int decodeInt24Ssse3(const juce::uint8* source, float* dest, int numSamples, float scale)
+{
+    auto multiplier = _mm_set1_ps(scale);
+    auto shuffle = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    int i = 0;
+    
+    // each load reads 16 bytes for 4 frames, so stay clear of the last frames
+    for (; i + 6 <= numSamples; i += 4)
+    {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3));
+        auto values = _mm_shuffle_epi8(bytes, shuffle);
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(values), multiplier));
+    }
+    
+    return i;
+}
+
+static bool hasSsse3()
+{
+   #if defined (__SSSE3__) || defined (__AVX__)
+    return true;
+   #else
+    static const bool result = juce::SystemStats::hasSSSE3();
+    return result;
+   #endif
+}
+#endif
+
+static void decodeInt24(const juce::uint8* source, float* dest, int numSamples, float gain)
+{
+    // values are shifted into the top of an int32 so the sign comes for free
+    const float scale = gain / (int24Scale * 256.0f);
+    int i = 0;
+   
+   #if BANDITEX_SSE2
+    if (hasSsse3())
+        i = decodeInt24Ssse3(source, dest, numSamples, scale);
+   #elif BANDITEX_NEON
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        auto bytes = vld3_u8(source + i * 3);
+        auto low = vorrq_u16(vmovl_u8(bytes.val[0]), vshlq_n_u16(vmovl_u8(bytes.val[1]), 8));
+        auto high = vmovl_s8(vreinterpret_s8_u8(bytes.val[2]));
+        
+        auto first = vorrq_s32(vshlq_n_s32(vmovl_s16(vget_low_s16(high)), 24), vreinterpretq_s32_u32(vshlq_n_u32(vmovl_u16(vget_low_u16(low)), 8)));
+        auto second = vorrq_s32(vshlq_n_s32(vmovl_s16(vget_high_s16(high)), 24), vreinterpretq_s32_u32(vshlq_n_u32(vmovl_u16(vget_high_u16(low)), 8)));
+        
+        vst1q_f32(dest + i, vmulq_n_f32(vcvtq_f32_s32(first), scale));
+        vst1q_f32(dest + i + 4, vmulq_n_f32(vcvtq_f32_s32(second), scale));
+    }
+   #endif
+    
+    for (; i < numSamples; ++i)
+    {
+        auto* bytes = source + i * 3;
+        auto value = (juce::int32) (((juce::uint32) bytes[0] << 8) | ((juce::uint32) bytes[1] << 16) | ((juce::uint32) bytes[2] << 24));
+        dest[i] = (float) value * scale;
+    }
+}
+
+#pragma mark -
+
+int SampleEncoding::getBytesPerSample(Type type)
+{
+    switch (type)
+    {
+        case int16:   return 2;
+        case int24:   return 3;
+        case float32: break;
+    }
+    
+    return 4;
+}
+
+void SampleEncoding::encode(Type type, const float* source, void* dest, int numSamples)
+{
+    switch (type)
+    {
+        case int16:
+        {
+            auto* samples = static_cast<juce::int16*>(dest);
+            for (int i = 0; i < numSamples; ++i)
+                samples[i] = (juce::int16) juce::roundToInt(juce::jlimit(-1.0f, 1.0f, source[i]) * int16Scale);
+            break;
+        }
+        case int24:
+        {
+            auto* bytes = static_cast<juce::uint8*>(dest);
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto value = juce::roundToInt(juce::jlimit(-1.0f, 1.0f, source[i]) * int24Scale);
+                bytes[i * 3] = (juce::uint8) (value & 0xff);
+                bytes[i * 3 + 1] = (juce::uint8) ((value >> 8) & 0xff);
+                bytes[i * 3 + 2] = (juce::uint8) ((value >> 16) & 0xff);
+            }
+            break;
+        }
+        case float32:
+            juce::FloatVectorOperations::copy(static_cast<float*>(dest), source, numSamples);
+            break;
+    }
+}
+
+void SampleEncoding::decode(Type type, const void* source, float* dest, int numSamples, float gain)
+{
+    switch (type)
+    {
+        case int16:
+            decodeInt16(static_cast<const juce::int16*>(source), dest, numSamples, gain);
+            break;
+        case int24:
+            decodeInt24(static_cast<const juce::uint8*>(source), dest, numSamples, gain);
+            break;
+        case float32:
+            juce::FloatVectorOperations::copyWithMultiply(dest, static_cast<const float*>(source), gain, numSamples);
+            break;
+    }
+}
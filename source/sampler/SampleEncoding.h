@@ -0,0 +1,22 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+
+// Encodings Sample can keep its frames in. The integer ones hold half or three
+// quarters of the float memory at the cost of clipping anything beyond full scale.
+struct SampleEncoding final
+{
+    enum Type
+    {
+        float32,
+        int16,
+        int24
+    };
+    
+    static int getBytesPerSample(Type type);
+    
+    static void encode(Type type, const float* source, void* dest, int numSamples);
+    // vectorised, as it runs on the audio thread for every resident frame played
+    static void decode(Type type, const void* source, float* dest, int numSamples, float gain = 1.0f);
+};
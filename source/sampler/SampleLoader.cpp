@@ -0,0 +1,401 @@
+
+#include "SampleLoader.h"
+
+
+struct SampleLoader::Batch
+{
+    juce::Array<juce::File> files;
+    Options options;
+    std::vector<std::optional<LoadedSample>> slots;
+    std::atomic<int> numFinished { 0 };
+    std::atomic<bool> cancelled { false };
+    
+    // streamed samples whose peaks cover only their head, with the key their pooled entry is under
+    std::vector<std::optional<SamplePool::Key>> partialPeaks;
+    
+    juce::CriticalSection peaksLock;
+    std::vector<std::pair<int, std::shared_ptr<const WaveformPeaks>>> finishedPeaks;
+};
+
+#pragma mark -
+
+class SampleLoader::Job : public juce::ThreadPoolJob
+{
+public:
+    Job(SampleLoader& l, std::shared_ptr<Batch> b, int i)
+        : juce::ThreadPoolJob("Sample loader"), loader(l), batch(std::move(b)), index(i)
+    {}
+    
+    bool belongsTo(const SampleLoader& l) const { return &loader == &l; }
+    
+protected:
+    SampleLoader& loader;
+    std::shared_ptr<Batch> batch;
+    const int index;
+    
+    bool isCancelled()
+    {
+        return shouldExit() || batch->cancelled;
+    }
+    
+    std::shared_ptr<const WaveformPeaks> readPeaks(juce::AudioFormatReader& reader)
+    {
+        const int blockLength = 1 << 16;
+        
+        juce::AudioSampleBuffer block ((int) reader.numChannels, blockLength);
+        auto peaks = std::make_shared<WaveformPeaks>();
+        
+        for (juce::int64 position = 0; position < reader.lengthInSamples && !isCancelled(); position += blockLength)
+        {
+            auto numThisTime = (int) juce::jmin((juce::int64) blockLength, reader.lengthInSamples - position);
+            reader.read(&block, 0, numThisTime, position, true, true);
+            peaks->append(block, 0, numThisTime);
+        }
+        
+        peaks->finish();
+        return peaks;
+    }
+};
+
+#pragma mark -
+
+class SampleLoader::LoadJob final : public Job
+{
+public:
+    using Job::Job;
+    
+    JobStatus runJob() override
+    {
+        if (!isCancelled())
+            batch->slots[(size_t) index] = readSample();
+        
+        batch->numFinished.fetch_add(1);
+        
+        // a cancelled batch is no longer the loader's, so it has nothing to report
+        if (!batch->cancelled)
+            loader.triggerAsyncUpdate();
+        
+        return jobHasFinished;
+    }
+    
+private:
+    std::optional<LoadedSample> readSample()
+    {
+        auto file = batch->files[index];
+        auto& options = batch->options;
+        
+        if (auto mappedReader = createMappedReader())
+        {
+            auto poolKey = SamplePool::Key { file.getFullPathName(), SamplePool::fingerprint(file), mappedReader->sampleRate, options.quality, options.encoding };
+            if (auto pooled = findPooled(poolKey))
+                return pooled;
+            
+            LoadedSample loaded { index, nullptr, readPeaks(*mappedReader) };
+            if (isCancelled())
+                return std::nullopt;
+            
+            loaded.sample = std::make_shared<const Sample>(std::move(mappedReader));
+            return addPooled(poolKey, std::move(loaded));
+        }
+        
+        std::unique_ptr<juce::AudioFormatReader> reader (loader.formatManager.createReaderFor(file));
+        if (reader == nullptr)
+            return std::nullopt;
+        
+        auto targetSampleRate = options.targetSampleRate > 0.0 ? options.targetSampleRate : reader->sampleRate;
+        auto isStreamed = (double) reader->lengthInSamples / reader->sampleRate > options.streamingThresholdSeconds;
+        
+        // the pool is asked first as it needs no reading, the cache only if the pool misses
+        auto poolKey = SamplePool::Key { file.getFullPathName(), SamplePool::fingerprint(file), targetSampleRate, options.quality, options.encoding };
+        if (auto pooled = findPooled(poolKey))
+        {
+            if (isStreamed)
+                notePartialPeaks(*reader, *pooled, poolKey);
+            
+            return pooled;
+        }
+        
+        std::optional<SampleCache::Key> cacheKey;
+        if (options.cache != nullptr && !isStreamed)
+            if (auto contentHash = options.cache->getContentHash(file))
+                cacheKey = SampleCache::Key { *contentHash, reader->sampleRate, targetSampleRate, options.quality };
+        
+        if (cacheKey.has_value())
+        {
+            LoadedSample cached { index, nullptr, {} };
+            cached.sample = options.cache->load(*cacheKey, cached.peaks);
+            
+            if (cached.sample != nullptr && options.encoding != Sample::Encoding::float32)
+                cached.sample = std::make_shared<const Sample>(*cached.sample, options.encoding);
+            
+            if (cached.sample != nullptr)
+                return addPooled(poolKey, std::move(cached));
+        }
+        
+        auto scratch = loader.takeScratch();
+        auto peaks = std::make_shared<WaveformPeaks>();
+        Sample::DecodeOptions decodeOptions { options.quality, options.encoding, peaks.get(), scratch.get(), &batch->cancelled };
+        std::shared_ptr<const Sample> sample;
+        
+        try
+        {
+            if (isStreamed)
+                sample = std::make_shared<const Sample>(file, *reader, targetSampleRate, options.residentLengthSeconds, decodeOptions);
+            else
+                sample = std::make_shared<const Sample>(*reader, targetSampleRate, decodeOptions);
+        }
+        catch (const std::exception& exception)
+        {
+            juce::ignoreUnused(exception);
+            DBG(exception.what());
+        }
+        
+        loader.returnScratch(std::move(scratch));
+        
+        if (sample == nullptr || isCancelled())
+            return std::nullopt;
+        
+        peaks->finish();
+        LoadedSample loaded { index, std::move(sample), std::move(peaks) };
+        
+        // the cache holds full precision frames only
+        if (cacheKey.has_value() && options.encoding == Sample::Encoding::float32 && !isCancelled())
+            options.cache->store(*cacheKey, *loaded.sample, *loaded.peaks);
+        
+        auto pooled = addPooled(poolKey, std::move(loaded));
+        if (isStreamed)
+            notePartialPeaks(*reader, pooled, poolKey);
+        
+        return pooled;
+    }
+    
+    // a streamed sample is published with the peaks of its head, the rest of its file is read
+    // for peaks once the batch is out so that loading never reads more than the head
+    void notePartialPeaks(const juce::AudioFormatReader& reader, const LoadedSample& loaded, const SamplePool::Key& poolKey)
+    {
+        auto numPeaks = (reader.lengthInSamples + WaveformPeaks::baseDecimation - 1) / WaveformPeaks::baseDecimation;
+        
+        if (loaded.peaks == nullptr || (juce::int64) loaded.peaks->getLevel(0).size() < numPeaks)
+            batch->partialPeaks[(size_t) index] = poolKey;
+    }
+    
+    std::optional<LoadedSample> findPooled(const SamplePool::Key& key)
+    {
+        if (batch->options.pool == nullptr)
+            return std::nullopt;
+        
+        if (auto entry = batch->options.pool->find(key))
+            return LoadedSample { index, std::move(entry->sample), std::move(entry->peaks) };
+        
+        return std::nullopt;
+    }
+    
+    LoadedSample addPooled(const SamplePool::Key& key, LoadedSample loaded)
+    {
+        if (batch->options.pool == nullptr)
+            return loaded;
+        
+        auto entry = batch->options.pool->add(key, { std::move(loaded.sample), std::move(loaded.peaks) });
+        return LoadedSample { index, std::move(entry.sample), std::move(entry.peaks) };
+    }
+    
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> createMappedReader()
+    {
+        auto file = batch->files[index];
+        auto* format = loader.formatManager.findFormatForFileExtension(file.getFileExtension());
+        if (format == nullptr)
+            return nullptr;
+        
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader (format->createMemoryMappedReader(file));
+        if (reader == nullptr
+            || (int) reader->numChannels > Sample::maxMappedChannels
+            || (batch->options.targetSampleRate > 0.0 && !juce::approximatelyEqual(reader->sampleRate, batch->options.targetSampleRate))
+            || !reader->mapEntireFile())
+            return nullptr;
+        
+        return reader;
+    }
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoadJob)
+};
+
+#pragma mark -
+
+class SampleLoader::PeaksJob final : public Job
+{
+public:
+    PeaksJob(SampleLoader& l, std::shared_ptr<Batch> b, int i, SamplePool::Key k)
+        : Job(l, std::move(b), i), poolKey(std::move(k))
+    {}
+    
+    JobStatus runJob() override
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader (loader.formatManager.createReaderFor(batch->files[index]));
+        if (reader == nullptr || isCancelled())
+            return jobHasFinished;
+        
+        auto peaks = readPeaks(*reader);
+        if (isCancelled())
+            return jobHasFinished;
+        
+        // the pool hands out the whole file's peaks from now on
+        if (batch->options.pool != nullptr)
+            batch->options.pool->setPeaks(poolKey, peaks);
+        
+        {
+            const juce::ScopedLock sl (batch->peaksLock);
+            batch->finishedPeaks.emplace_back(index, std::move(peaks));
+        }
+        
+        if (!batch->cancelled)
+            loader.triggerAsyncUpdate();
+        
+        return jobHasFinished;
+    }
+    
+private:
+    const SamplePool::Key poolKey;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PeaksJob)
+};
+
+#pragma mark -
+
+class SampleLoader::OwnJobs final : public juce::ThreadPool::JobSelector
+{
+public:
+    explicit OwnJobs(const SampleLoader& l) : loader(l) {}
+    
+    bool isJobSuitable(juce::ThreadPoolJob* job) override
+    {
+        auto* loaderJob = dynamic_cast<Job*>(job);
+        return loaderJob != nullptr && loaderJob->belongsTo(loader);
+    }
+    
+private:
+    const SampleLoader& loader;
+};
+
+#pragma mark -
+
+SampleLoader::SampleLoader(juce::AudioFormatManager& manager)
+    : formatManager(manager)
+{
+}
+
+SampleLoader::~SampleLoader()
+{
+    // running jobs use the loader until they return, so here they are waited for; they stop at their next block
+    for (auto& batch : { currentBatch, finishedBatch })
+        if (batch != nullptr)
+            batch->cancelled = true;
+    
+    cancelPendingUpdate();
+    
+    OwnJobs ownJobs (*this);
+    pool->removeAllJobs(true, -1, &ownJobs);
+}
+
+void SampleLoader::load(const juce::Array<juce::File>& files, const Options& options)
+{
+    cancel();
+    
+    currentBatch = std::make_shared<Batch>();
+    currentBatch->files = files;
+    currentBatch->options = options;
+    currentBatch->slots.resize((size_t) files.size());
+    currentBatch->partialPeaks.resize((size_t) files.size());
+    
+    for (int i = 0; i < files.size(); ++i)
+        pool->addJob(new LoadJob(*this, currentBatch, i), true);
+    
+    if (files.isEmpty())
+        triggerAsyncUpdate();
+}
+
+void SampleLoader::cancel()
+{
+    for (auto& batch : { currentBatch, finishedBatch })
+        if (batch != nullptr)
+            batch->cancelled = true;
+    
+    // never waits: queued jobs go now, running ones give up at their next block and keep
+    // only their own batch alive until then
+    OwnJobs ownJobs (*this);
+    pool->removeAllJobs(true, 0, &ownJobs);
+    cancelPendingUpdate();
+    currentBatch.reset();
+    finishedBatch.reset();
+}
+
+bool SampleLoader::isLoading() const
+{
+    return currentBatch != nullptr;
+}
+
+std::unique_ptr<SampleDecodeScratch> SampleLoader::takeScratch()
+{
+    const juce::ScopedLock sl (scratchLock);
+    
+    if (spareScratch.empty())
+        return std::make_unique<SampleDecodeScratch>();
+    
+    auto scratch = std::move(spareScratch.back());
+    spareScratch.pop_back();
+    return scratch;
+}
+
+void SampleLoader::returnScratch(std::unique_ptr<SampleDecodeScratch> scratch)
+{
+    const juce::ScopedLock sl (scratchLock);
+    spareScratch.push_back(std::move(scratch));
+}
+
+#pragma mark -
+
+void SampleLoader::handleAsyncUpdate()
+{
+    if (currentBatch != nullptr)
+    {
+        auto numTotal = currentBatch->files.size();
+        auto numLoaded = currentBatch->numFinished.load();
+        
+        if (onProgress)
+            onProgress(numLoaded, numTotal);
+        
+        if (numLoaded == numTotal)
+            finishBatch();
+    }
+    
+    // peaks are only handed out after the samples they belong to
+    if (finishedBatch != nullptr)
+    {
+        std::vector<std::pair<int, std::shared_ptr<const WaveformPeaks>>> peaks;
+        
+        {
+            const juce::ScopedLock sl (finishedBatch->peaksLock);
+            std::swap(peaks, finishedBatch->finishedPeaks);
+        }
+        
+        for (auto& [ordinal, samplePeaks] : peaks)
+            if (onPeaksFinished)
+                onPeaksFinished(ordinal, std::move(samplePeaks));
+    }
+}
+
+void SampleLoader::finishBatch()
+{
+    Results results;
+    for (auto& slot : currentBatch->slots)
+        if (slot.has_value())
+            results.push_back(std::move(*slot));
+    
+    finishedBatch = std::move(currentBatch);
+    
+    for (int i = 0; i < finishedBatch->files.size(); ++i)
+        if (auto& poolKey = finishedBatch->partialPeaks[(size_t) i])
+            pool->addJob(new PeaksJob(*this, finishedBatch, i, *poolKey), true);
+    
+    if (onFinished)
+        onFinished(std::move(results));
+}
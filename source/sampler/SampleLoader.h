@@ -0,0 +1,77 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_events/juce_events.h>
+#include "models/Sample.h"
+#include "models/WaveformPeaks.h"
+#include "sampler/SampleCache.h"
+#include "sampler/SamplePool.h"
+
+
+class SampleLoader final : private juce::AsyncUpdater
+{
+public:
+    struct LoadedSample
+    {
+        int ordinal;
+        std::shared_ptr<const Sample> sample;
+        std::shared_ptr<const WaveformPeaks> peaks;
+    };
+    
+    using Results = std::vector<LoadedSample>;
+    
+    struct Options
+    {
+        double targetSampleRate = 0.0;
+        double streamingThresholdSeconds = 30.0;
+        double residentLengthSeconds = 2.0;
+        Sample::Quality quality = Sample::Quality::standard;
+        Sample::Encoding encoding = Sample::Encoding::float32;
+        const SampleCache* cache = nullptr;
+        SamplePool* pool = nullptr;
+    };
+    
+    explicit SampleLoader(juce::AudioFormatManager& manager);
+    ~SampleLoader() override;
+    
+    // both called on the message thread
+    std::function<void(int numLoaded, int numTotal)> onProgress;
+    std::function<void(Results results)> onFinished;
+    // a streamed sample's peaks cover only its head until the rest of its file has been read
+    std::function<void(int ordinal, std::shared_ptr<const WaveformPeaks> peaks)> onPeaksFinished;
+    
+    void load(const juce::Array<juce::File>& files, const Options& options);
+    void cancel();
+    
+    bool isLoading() const;
+    
+private:
+    struct Batch;
+    class Job;
+    class LoadJob;
+    class PeaksJob;
+    class OwnJobs;
+    
+    // one set of loading threads for every loader in the process, each loader only ever removes its own jobs
+    struct SharedThreadPool : juce::ThreadPool {};
+    
+    juce::AudioFormatManager& formatManager;
+    std::shared_ptr<Batch> currentBatch;
+    // the last batch handed out, its streamed samples may still be having their peaks read
+    std::shared_ptr<Batch> finishedBatch;
+    
+    // decode scratch is shared by the worker threads, so loading memory stays bounded by the thread count
+    juce::CriticalSection scratchLock;
+    std::vector<std::unique_ptr<SampleDecodeScratch>> spareScratch;
+    
+    // last, so the loader has waited for its jobs before anything they use is destroyed
+    juce::SharedResourcePointer<SharedThreadPool> pool;
+    
+    std::unique_ptr<SampleDecodeScratch> takeScratch();
+    void returnScratch(std::unique_ptr<SampleDecodeScratch> scratch);
+    
+    void handleAsyncUpdate() override;
+    void finishBatch();
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleLoader)
+};
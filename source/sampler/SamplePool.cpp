@@ -0,0 +1,127 @@
+
+#include "SamplePool.h"
+
+
+bool SamplePool::Key::operator < (const Key& rhs) const
+{
+    return std::tie(fingerprint, targetSampleRate, quality, encoding, path)
+        < std::tie(rhs.fingerprint, rhs.targetSampleRate, rhs.quality, rhs.encoding, rhs.path);
+}
+
+#pragma mark -
+
+std::optional<SamplePool::Entry> SamplePool::find(const Key& key)
+{
+    const juce::ScopedLock sl (lock);
+    
+    auto slot = slots.find(key);
+    if (slot == slots.end())
+        return std::nullopt;
+    
+    auto sample = slot->second.sample.lock();
+    if (sample == nullptr)
+    {
+        slots.erase(slot);
+        return std::nullopt;
+    }
+    
+    keep(slot->second, sample);
+    evict();
+    
+    return Entry { std::move(sample), slot->second.peaks };
+}
+
+SamplePool::Entry SamplePool::add(const Key& key, Entry entry)
+{
+    const juce::ScopedLock sl (lock);
+    purge();
+    
+    auto& slot = slots[key];
+    if (auto pooled = slot.sample.lock())
+        entry = Entry { std::move(pooled), slot.peaks };
+    
+    slot.sample = entry.sample;
+    slot.peaks = entry.peaks;
+    keep(slot, entry.sample);
+    evict();
+    
+    return entry;
+}
+
+void SamplePool::setPeaks(const Key& key, std::shared_ptr<const WaveformPeaks> peaks)
+{
+    const juce::ScopedLock sl (lock);
+    
+    auto slot = slots.find(key);
+    if (slot != slots.end())
+        slot->second.peaks = std::move(peaks);
+}
+
+int SamplePool::getNumSamples()
+{
+    const juce::ScopedLock sl (lock);
+    purge();
+    
+    return (int) slots.size();
+}
+
+void SamplePool::setBudget(size_t numBytes)
+{
+    const juce::ScopedLock sl (lock);
+    
+    budget = numBytes;
+    evict();
+}
+
+size_t SamplePool::getNumBytesKept()
+{
+    const juce::ScopedLock sl (lock);
+    return numBytesKept;
+}
+
+juce::uint64 SamplePool::fingerprint(const juce::File& file)
+{
+    return (juce::uint64) file.getSize() * 1099511628211ull ^ (juce::uint64) file.getLastModificationTime().toMilliseconds();
+}
+
+#pragma mark -
+
+void SamplePool::keep(Slot& slot, std::shared_ptr<const Sample> sample)
+{
+    if (slot.kept == nullptr)
+        numBytesKept += sample->getMemoryUsage();
+    
+    slot.kept = std::move(sample);
+    slot.lastUsed = ++useCount;
+}
+
+void SamplePool::evict()
+{
+    while (numBytesKept > budget)
+    {
+        auto oldest = slots.end();
+        
+        for (auto slot = slots.begin(); slot != slots.end(); ++slot)
+            if (slot->second.kept != nullptr && (oldest == slots.end() || slot->second.lastUsed < oldest->second.lastUsed))
+                oldest = slot;
+        
+        if (oldest == slots.end())
+            break;
+        
+        numBytesKept -= oldest->second.kept->getMemoryUsage();
+        oldest->second.kept.reset();
+    }
+    
+    purge();
+}
+
+void SamplePool::purge()
+{
+    for (auto slot = slots.begin(); slot != slots.end();)
+    {
+        if (slot->second.sample.expired())
+            slot = slots.erase(slot);
+        else
+            ++slot;
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "models/Sample.h"
+#include "models/WaveformPeaks.h"
+
+
+// Process-wide registry of loaded samples, shared by every processor and plugin
+// instance through juce::SharedResourcePointer. The most recently used samples are
+// kept alive up to a byte budget, so loading a set again soon after it went away
+// decodes nothing; beyond the budget the least recently used ones are let go and
+// freed once the last sample set holding them goes away.
+class SamplePool final
+{
+public:
+    static constexpr size_t defaultBudget = (size_t) 512 << 20;
+    
+    struct Key
+    {
+        juce::String path;
+        juce::uint64 fingerprint;
+        double targetSampleRate;
+        Sample::Quality quality;
+        Sample::Encoding encoding;
+        
+        bool operator < (const Key& rhs) const;
+    };
+    
+    struct Entry
+    {
+        std::shared_ptr<const Sample> sample;
+        std::shared_ptr<const WaveformPeaks> peaks;
+    };
+    
+    SamplePool() = default;
+    
+    // all safe to call from any thread
+    std::optional<Entry> find(const Key& key);
+    // returns the already pooled entry if another loader got there first
+    Entry add(const Key& key, Entry entry);
+    // e.g. once a streamed sample's peaks cover its whole file rather than its head
+    void setPeaks(const Key& key, std::shared_ptr<const WaveformPeaks> peaks);
+    
+    int getNumSamples();
+    
+    // samples kept alive count against the budget whether or not a set still plays them
+    void setBudget(size_t numBytes);
+    size_t getNumBytesKept();
+    
+    // Samples are looked up by the file's size and modification time, which needs no
+    // reading, so a pooled sample costs nothing to find again however large its file.
+    static juce::uint64 fingerprint(const juce::File& file);
+    
+private:
+    struct Slot
+    {
+        std::weak_ptr<const Sample> sample;
+        std::shared_ptr<const WaveformPeaks> peaks;
+        
+        // set while the slot is within the budget
+        std::shared_ptr<const Sample> kept;
+        juce::uint64 lastUsed = 0;
+    };
+    
+    juce::CriticalSection lock;
+    std::map<Key, Slot> slots;
+    size_t budget = defaultBudget;
+    size_t numBytesKept = 0;
+    juce::uint64 useCount = 0;
+    
+    void keep(Slot& slot, std::shared_ptr<const Sample> sample);
+    void evict();
+    void purge();
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SamplePool)
+};
@@ -0,0 +1,213 @@
+
+#include "SampleStreamer.h"
+
+
+static constexpr int blockLength = 4096;
+
+SampleStreamer::SampleStreamer(juce::AudioFormatManager& manager, int numStreams, int numChannels)
+    : formatManager(manager)
+{
+    for (int i = 0; i < numStreams; ++i)
+    {
+        auto stream = std::make_unique<Stream>();
+        stream->buffer.setSize(numChannels, bufferLength);
+        streams.push_back(std::move(stream));
+    }
+    
+    scratch.setSize(numChannels, blockLength);
+    
+    thread->addTimeSliceClient(this);
+}
+
+SampleStreamer::~SampleStreamer()
+{
+    // waits for this streamer's time slice if it is running
+    thread->removeTimeSliceClient(this);
+}
+
+#pragma mark -
+
+void SampleStreamer::addSource(const Sample* sample)
+{
+    const juce::ScopedLock sl (sourcesLock);
+    ++sources[sample];
+}
+
+void SampleStreamer::removeSource(const Sample* sample)
+{
+    const juce::ScopedLock sl (sourcesLock);
+    if (--sources[sample] <= 0)
+        sources.erase(sample);
+}
+
+#pragma mark -
+
+void SampleStreamer::start(int streamIndex, const Sample* sample, juce::int64 position)
+{
+    auto& stream = *streams[(size_t) streamIndex];
+    
+    stream.requestedSample.store(sample, std::memory_order_relaxed);
+    stream.requestedPosition.store(position, std::memory_order_relaxed);
+    stream.requestedGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void SampleStreamer::stop(int streamIndex)
+{
+    start(streamIndex, nullptr, 0);
+}
+
+int SampleStreamer::read(int streamIndex, juce::AudioBuffer<float>& dest, int destStart, int numFrames, float startGain, float endGain)
+{
+    auto& stream = *streams[(size_t) streamIndex];
+    
+    if (stream.readyGeneration.load(std::memory_order_acquire) != stream.requestedGeneration.load(std::memory_order_relaxed))
+        return 0;
+    
+    int start1, size1, start2, size2;
+    stream.fifo.prepareToRead(numFrames, start1, size1, start2, size2);
+    
+    auto increment = numFrames > 0 ? (endGain - startGain) / (float) numFrames : 0.0f;
+    auto middleGain = startGain + increment * (float) size1;
+    
+    for (int ch = 0; ch < dest.getNumChannels(); ++ch)
+    {
+        auto sourceChannel = ch % stream.buffer.getNumChannels();
+        
+        if (size1 > 0)
+            dest.copyFromWithRamp(ch, destStart, stream.buffer.getReadPointer(sourceChannel, start1), size1, startGain, middleGain);
+        
+        if (size2 > 0)
+            dest.copyFromWithRamp(ch, destStart + size1, stream.buffer.getReadPointer(sourceChannel, start2), size2, middleGain, middleGain + increment * (float) size2);
+    }
+    
+    stream.fifo.finishedRead(size1 + size2);
+    return size1 + size2;
+}
+
+#pragma mark -
+
+int SampleStreamer::useTimeSlice()
+{
+    bool isBusy = false;
+    
+    for (auto& stream : streams)
+    {
+        auto generation = stream->requestedGeneration.load(std::memory_order_acquire);
+        if (generation != stream->generation)
+            open(*stream, generation);
+        
+        isBusy = fill(*stream) || isBusy;
+    }
+    
+    return isBusy ? 1 : 10;
+}
+
+void SampleStreamer::open(Stream& stream, int generation)
+{
+    stream.resampler.reset();
+    stream.reader.reset();
+    stream.remaining = 0;
+    stream.fifo.reset();
+    stream.generation = generation;
+    
+    auto* sample = stream.requestedSample.load(std::memory_order_relaxed);
+    auto position = stream.requestedPosition.load(std::memory_order_relaxed);
+    
+    juce::File file;
+    double sampleRate = 0.0;
+    juce::int64 numSamples = 0;
+    auto quality = Sample::Quality::standard;
+    
+    // only what's needed is copied under the lock, the file is opened without it so a slow
+    // disk never holds up adding or removing sources
+    if (sample != nullptr)
+    {
+        const juce::ScopedLock sl (sourcesLock);
+        
+        if (sources.contains(sample))
+        {
+            file = sample->getFile();
+            sampleRate = sample->getSampleRate();
+            numSamples = sample->getNumSamples();
+            quality = sample->getQuality();
+        }
+    }
+    
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    if (file != juce::File())
+        reader.reset(formatManager.createReaderFor(file));
+    
+    if (reader != nullptr)
+    {
+        auto ratio = reader->sampleRate / sampleRate;
+        
+        // frames are resampled by their index like the head was, so the tail goes on from
+        // the exact frame the head stopped at rather than from a rounded source position
+        std::unique_ptr<SincResampler> resampler;
+        if (!juce::approximatelyEqual(ratio, 1.0))
+        {
+            resampler = std::make_unique<SincResampler>(ratio, quality);
+            
+            auto windowLength = (int) std::ceil(blockLength * ratio) + resampler->getNumTaps() + 2;
+            if (window.getNumSamples() < windowLength)
+                window.setSize(stream.buffer.getNumChannels(), windowLength);
+        }
+        
+        const juce::ScopedLock sl (sourcesLock);
+        
+        // the sample may have been removed while its file was opening
+        if (sources.contains(sample))
+        {
+            stream.reader = std::move(reader);
+            stream.resampler = std::move(resampler);
+            stream.position = position;
+            stream.remaining = numSamples - position;
+        }
+    }
+    
+    stream.readyGeneration.store(generation, std::memory_order_release);
+}
+
+bool SampleStreamer::fill(Stream& stream)
+{
+    if (stream.reader == nullptr || stream.remaining <= 0)
+        return false;
+    
+    auto numToWrite = (int) juce::jmin((juce::int64) juce::jmin(stream.fifo.getFreeSpace(), blockLength), stream.remaining);
+    if (numToWrite < blockLength / 4 && numToWrite < stream.remaining)
+        return false;
+    
+    if (stream.resampler != nullptr)
+    {
+        // the frames around the resident end are read from the file again, they are the
+        // same ones the head was decoded from
+        auto first = stream.resampler->getFirstInputFrame(stream.position);
+        auto windowLength = (int) (stream.resampler->getLastInputFrame(stream.position + numToWrite - 1) - first + 1);
+        jassert(windowLength <= window.getNumSamples());
+        
+        stream.reader->read(&window, 0, windowLength, first, true, true);
+        stream.resampler->process(window, first, windowLength, stream.position, scratch.getArrayOfWritePointers(), numToWrite);
+    }
+    else
+    {
+        stream.reader->read(&scratch, 0, numToWrite, stream.position, true, true);
+    }
+    
+    int start1, size1, start2, size2;
+    stream.fifo.prepareToWrite(numToWrite, start1, size1, start2, size2);
+    
+    for (int ch = 0; ch < stream.buffer.getNumChannels(); ++ch)
+    {
+        if (size1 > 0)
+            stream.buffer.copyFrom(ch, start1, scratch, ch, 0, size1);
+        
+        if (size2 > 0)
+            stream.buffer.copyFrom(ch, start2, scratch, ch, size1, size2);
+    }
+    
+    stream.fifo.finishedWrite(size1 + size2);
+    stream.position += size1 + size2;
+    stream.remaining -= size1 + size2;
+    
+    return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "models/Sample.h"
+#include "sampler/SincResampler.h"
+
+
+class SampleStreamer final : private juce::TimeSliceClient
+{
+public:
+    static constexpr int bufferLength = 1 << 16;
+    
+    SampleStreamer(juce::AudioFormatManager& manager, int numStreams, int numChannels);
+    ~SampleStreamer() override;
+    
+    // message thread: only registered samples are ever opened by the reader thread
+    void addSource(const Sample* sample);
+    void removeSource(const Sample* sample);
+    
+    // audio thread
+    void start(int stream, const Sample* sample, juce::int64 position);
+    void stop(int stream);
+    // gain ramps linearly from startGain to endGain across the frames asked for, like Sample::read
+    int read(int stream, juce::AudioBuffer<float>& dest, int destStart, int numFrames, float startGain = 1.0f, float endGain = 1.0f);
+    
+private:
+    struct Stream
+    {
+        std::atomic<const Sample*> requestedSample { nullptr };
+        std::atomic<juce::int64> requestedPosition { 0 };
+        std::atomic<int> requestedGeneration { 0 };
+        std::atomic<int> readyGeneration { 0 };
+        
+        juce::AbstractFifo fifo { bufferLength };
+        juce::AudioSampleBuffer buffer;
+        
+        int generation = 0;
+        juce::int64 position = 0;
+        juce::int64 remaining = 0;
+        std::unique_ptr<juce::AudioFormatReader> reader;
+        
+        // the same kernel and tier the sample's head was decoded with, null when the file
+        // is already at the sample's rate
+        std::unique_ptr<SincResampler> resampler;
+    };
+    
+    // one reading thread for every streamer in the process, each streamer is a client of it
+    struct SharedThread : juce::TimeSliceThread
+    {
+        SharedThread() : juce::TimeSliceThread("Sample streamer") { startThread(juce::Thread::Priority::high); }
+        ~SharedThread() override { stopThread(1000); }
+    };
+    
+    juce::AudioFormatManager& formatManager;
+    juce::SharedResourcePointer<SharedThread> thread;
+    std::vector<std::unique_ptr<Stream>> streams;
+    juce::AudioSampleBuffer scratch;
+    juce::AudioSampleBuffer window;
+    
+    juce::CriticalSection sourcesLock;
+    std::map<const Sample*, int> sources;
+    
+    int useTimeSlice() override;
+    void open(Stream& stream, int generation);
+    bool fill(Stream& stream);
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleStreamer)
+};
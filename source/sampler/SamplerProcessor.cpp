@@ -1,89 +1,154 @@
 
 #include "sampler/SamplerProcessor.h"
 #include "gui/SamplerEditor.h"
-#include <algorithm>
-#include <iterator>
-#include <random>
+#include <utility>
 
 
+static constexpr double stopFadeSeconds = 0.02;
+
+// bounds the work of one render when samples keep failing to start or end straight away
+static constexpr int maxAdvancesPerRender = 64;
+
 SamplerProcessor::SamplerProcessor()
     : ProcessorBase(),
-    parameters(*this, nullptr, juce::Identifier ("Sampler Parameters"), {
-        std::make_unique<juce::AudioParameterBool> (juce::ParameterID ("bypass", 1), "Bypass", false),
-        std::make_unique<juce::AudioParameterBool> (juce::ParameterID ("loop", 1), "Loop", false),
-        std::make_unique<juce::AudioParameterBool> (juce::ParameterID ("shuffle", 1), "Shuffle", false),
-        std::make_unique<juce::AudioParameterFloat> (juce::ParameterID ("pitch", 1), "Pitch", -2.5f, 2.5f, 0.0f),
-        std::make_unique<juce::AudioParameterFloat> (juce::ParameterID ("level", 1), "Level", 0.0f, 1.0f, 0.75f)
-    })
+    bypassParameter(registry.addBool("bypass", { "bypass", 1 }, "Bypass", false)),
+    loopParameter(registry.addBool("loop", { "loop", 1 }, "Loop", false)),
+    playbackOrderParameter(registry.addChoice("playbackorder", { "playbackorder", 1 }, "Playback order", PlaybackOrder::labels, PlaybackOrder::Order::ordinal,
+                           juce::AudioParameterChoiceAttributes().withAutomatable(false))),
+    pitchParameter(registry.addFloat("pitch", { "pitch", 1 }, "Pitch", { -2.5f, 2.5f }, 0.0f,
+                   juce::AudioParameterFloatAttributes().withLabel("st"))),
+    levelParameter(registry.addFloat("level", { "level", 1 }, "Level", 0.0f, 1.0f, 0.75f)),
+    loopModeParameter(registry.addChoice("loop", { "loopmode", 1 }, "Loop mode", LoopMode::labels, LoopMode::Mode::none)),
+    fadeLengthParameter(registry.addFloat("loop", { "fadelength", 1 }, "Fade length", { 0.0f, 5.0f, 0.0f, 0.5f }, 0.5f,
+                        juce::AudioParameterFloatAttributes().withLabel("s"))),
+    triggerRateParameter(registry.addFloat("loop", { "triggerrate", 1 }, "Trigger rate", { 0.1f, 5.0f, 0.0f, 0.5f }, 0.5f,
+                         juce::AudioParameterFloatAttributes().withLabel("Hz"))),
+    gapLengthParameter(registry.addFloat("loop", { "gaplength", 1 }, "Gap length", { 0.0f, 5.0f, 0.0f, 0.5f }, 0.5f,
+                       juce::AudioParameterFloatAttributes().withLabel("s"))),
+    storageParameter(registry.addChoice("storage", { "storage", 1 }, "Storage", storageLabels, Storage::float32,
+                     juce::AudioParameterChoiceAttributes().withAutomatable(false))),
+    stealingParameter(registry.addChoice("voicestealing", { "voicestealing", 1 }, "Voice stealing", VoicePool::stealingLabels, VoicePool::Stealing::oldest,
+                      juce::AudioParameterChoiceAttributes().withAutomatable(false))),
+    interpolationParameter(registry.addChoice("interpolation", { "interpolation", 1 }, "Interpolation", VarispeedInterpolator::labels, VarispeedInterpolator::Type::cubic,
+                           juce::AudioParameterChoiceAttributes().withAutomatable(false))),
+    parameters(*this, nullptr, juce::Identifier ("Sampler Parameters"), registry.takeLayout()),
+    bypassHandle(snapshot.add(parameters.getRawParameterValue("bypass"))),
+    pitchHandle(snapshot.add(parameters.getRawParameterValue("pitch"))),
+    loopHandle(snapshot.add(parameters.getRawParameterValue("loop"))),
+    fadeLengthHandle(snapshot.add(parameters.getRawParameterValue("fadelength"))),
+    triggerRateHandle(snapshot.add(parameters.getRawParameterValue("triggerrate"))),
+    gapLengthHandle(snapshot.add(parameters.getRawParameterValue("gaplength"))),
+    levelHandle(snapshot.add(parameters.getRawParameterValue("level"), 0.02))
 {
     formatManager.registerBasicFormats();
-    parameters.addParameterListener("shuffle", this);
+    
+    // a new order starts a fresh pass once the sample playing now is done
+    registry.call("playbackorder", [this] { playlist.restart(playlistSize, registry.get(playbackOrderParameter)); });
+    registry.call("storage", [this] { storageChanged = true; });
+    
+    sampleLoader.onProgress = [this] (int numLoaded, int numTotal)
+    {
+        loadingProgress = numTotal > 0 ? (double) numLoaded / numTotal : 1.0;
+        sendChangeMessage();
+    };
+    sampleLoader.onFinished = [this] (SampleLoader::Results results)
+    {
+        publishSamples(std::move(results), std::exchange(isReloading, false));
+    };
+    sampleLoader.onPeaksFinished = [this] (int ordinal, std::shared_ptr<const WaveformPeaks> peaks)
+    {
+        if (ordinal < (int) waveformPeaks.size())
+        {
+            waveformPeaks[(size_t) ordinal] = std::move(peaks);
+            sendChangeMessage();
+        }
+    };
+    
+    startTimer(500);
 }
 
 SamplerProcessor::~SamplerProcessor()
 {
-    parameters.removeParameterListener("shuffle", this);
+    stopTimer();
+    sampleLoader.cancel();
 }
 
-void SamplerProcessor::prepareToPlay (double, int)
+void SamplerProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    reset();
+    snapshot.prepare(sampleRate);
+    voices.prepare(sampleRate, getTotalNumOutputChannels(), samplesPerBlock);
+    
+    // hosts may prepare from any thread, so the reload is left to the timer, which owns the loading
+    // state; the current set keeps playing until the library is ready at the new rate
+    preparedSampleRate = sampleRate;
+    sampleRateChanged = true;
 }
 
 void SamplerProcessor::releaseResources()
 {
-    samplesBuffer.setSize(0, 0);
-    samplesSpecs.clear();
 }
 
-void SamplerProcessor::processBlock (juce::AudioBuffer<float>& audioBuffer, juce::MidiBuffer&)
+void SamplerProcessor::processBlock (juce::AudioBuffer<float>& audioBuffer, juce::MidiBuffer& midiBuffer)
 {
-    if (getBypassParameter()->getValue() > 0.5f)
-        return;
+    adoptSampleSet();
+    snapshot.update(audioBuffer.getNumSamples());
+    voices.setStealing(registry.get(stealingParameter));
+    voices.setInterpolation(registry.get(interpolationParameter));
     
-    if (currentSampleIndex == -1)
-        advanceToNextSample();
-
-    auto numOutputChannels = audioBuffer.getNumChannels();
-    auto outSamplesRemaining = audioBuffer.getNumSamples();
-    auto outSamplesOffset = 0;
+    // pitch is in semitones, each voice glides to the new speed on its own
+    voices.setSpeed(std::exp2(snapshot.get(pitchHandle) / 12.0f));
     
-    while (outSamplesRemaining > 0)
+    transport.handleCommands([this] (Transport::Command command) { applyTransportCommand(command); });
+    
+    // releases still count while bypassed, so a note let go meanwhile can't keep playback going afterwards
+    if (snapshot.isOn(bypassHandle))
     {
-        auto currentSampleSpec = samplesSpecs[(size_t) currentSampleIndex];
-        auto inSamplesRemaining = currentSampleSpec.end - currentPosition;
-        auto inSamplesThisTime = juce::jmin(outSamplesRemaining, inSamplesRemaining);
-        
-        for (auto ch = 0; ch < numOutputChannels; ++ch)
-            audioBuffer.copyFrom(ch, outSamplesOffset, samplesBuffer, ch % samplesBuffer.getNumChannels(), currentPosition, inSamplesThisTime);
+        for (const auto metadata : midiBuffer)
+            if (auto message = metadata.getMessage(); !message.isNoteOn())
+                handleMidiMessage(message);
         
-        outSamplesRemaining -= inSamplesThisTime;
-        outSamplesOffset += inSamplesThisTime;
-        currentPosition += inSamplesThisTime;
-
-        if (currentPosition == currentSampleSpec.end)
-        {
-            advanceToNextSample();
-            if (currentSampleIndex == -1)
-            {
-                suspendProcessing(true);
-                sendChangeMessage();
-                break;
-            }
-        }
+        return;
     }
     
-    for (int ch = 0; ch < audioBuffer.getNumChannels(); ++ch)
-        for (int sample = 0; sample < audioBuffer.getNumSamples(); ++sample)
-            audioBuffer.setSample(ch, sample, audioBuffer.getSample(ch, sample) * *parameters.getRawParameterValue("level"));
+    audioBuffer.clear();
+    
+    // rendering is split at every MIDI event, so a note lands on its own frame whatever the block size
+    auto position = 0;
+    
+    for (const auto metadata : midiBuffer)
+    {
+        auto eventPosition = juce::jlimit(position, audioBuffer.getNumSamples(), metadata.samplePosition);
+        renderPlaylist(audioBuffer, position, eventPosition - position);
+        handleMidiMessage(metadata.getMessage());
+        position = eventPosition;
+    }
+    
+    renderPlaylist(audioBuffer, position, audioBuffer.getNumSamples() - position);
+    
+    if (transport.getState() == Transport::State::stopping && voices.getNumActive() == 0)
+    {
+        transport.finishStopping();
+        events.push({ PlaybackEvent::Type::transportStopped });
+    }
+    
+    snapshot.applyGain(levelHandle, audioBuffer, 0, audioBuffer.getNumSamples());
 }
 
 void SamplerProcessor::reset()
 {
-    suspendProcessing(true);
-    releaseResources();
-    currentSampleIndex = -1;
-    currentPosition = 0;
+    transport.send(Transport::Command::stop);
+    sampleLoader.cancel();
+    loadingProgress = 0.0;
+    loadedFiles.clear();
+    isReloading = false;
+    
+    waveformPeaks.clear();
+    sampleGains.clear();
+    
+    auto set = std::make_unique<SampleSet>(sampleStreamer);
+    publishedSet = set.get();
+    sampleSets.publish(std::move(set));
+    restartPlaylist(0);
 
     sendChangeMessage();
 }
@@ -97,7 +162,7 @@ juce::AudioProcessorEditor* SamplerProcessor::createEditor()
 
 juce::AudioProcessorParameter* SamplerProcessor::getBypassParameter() const
 {
-    return parameters.getParameter("bypass");
+    return registry.raw(bypassParameter);
 }
 
 const juce::String SamplerProcessor::getName() const
@@ -107,92 +172,454 @@ const juce::String SamplerProcessor::getName() const
 
 #pragma mark -
 
-void SamplerProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+void SamplerProcessor::timerCallback()
 {
-    if (parameterID == "shuffle")
-        setIsShuffling(newValue > 0.5f);
+    sampleSets.collect();
+    
+    auto isRateChanged = sampleRateChanged.exchange(false) && !juce::approximatelyEqual(preparedSampleRate.load(), loadedSampleRate);
+    auto isStorageChanged = storageChanged.exchange(false);
+    
+    if ((isRateChanged || isStorageChanged) && !loadedFiles.isEmpty())
+    {
+        isReloading = true;
+        loadFiles(isRateChanged ? preparedSampleRate.load() : loadedSampleRate);
+    }
 }
 
 #pragma mark -
 
+SamplerProcessor::SampleSet::~SampleSet()
+{
+    for (auto& sample : samples)
+        if (sample->isStreamed())
+            streamer.removeSource(sample.get());
+}
+
 void SamplerProcessor::readFiles(juce::Array<juce::File>& files)
 {
-    reset();
+    loadedFiles = files;
+    sampleGains.assign((size_t) files.size(), 1.0f);
+    isReloading = false;
+    loadFiles(getSampleRate());
+}
+
+void SamplerProcessor::loadFiles(double sampleRate)
+{
+    SampleLoader::Options options;
+    options.targetSampleRate = sampleRate;
+    options.cache = &sampleCache.getObject();
+    options.pool = &samplePool.getObject();
+    options.encoding = getStorageEncoding();
+    
+    loadedSampleRate = sampleRate;
+    loadingProgress = 0.0;
+    sampleLoader.load(loadedFiles, options);
+    sendChangeMessage();
+}
+
+Sample::Encoding SamplerProcessor::getStorageEncoding() const
+{
+    switch (registry.get(storageParameter))
+    {
+        case Storage::int24:   return Sample::Encoding::int24;
+        case Storage::int16:   return Sample::Encoding::int16;
+        case Storage::float32: break;
+    }
+    
+    return Sample::Encoding::float32;
+}
+
+void SamplerProcessor::publishSamples(SampleLoader::Results results, bool continuesPlayback)
+{
+    auto set = std::make_unique<SampleSet>(sampleStreamer);
+    set->sampleRate = loadedSampleRate;
+    set->continuesPlayback = continuesPlayback;
     
-    waveformPeaks.resize(files.size());
+    waveformPeaks.clear();
+    waveformPeaks.resize(results.empty() ? 0 : (size_t) results.back().ordinal + 1);
     
-    for (int i = 0; i < files.size(); ++i)
+    set->gains = std::vector<std::atomic<float>>(sampleGains.size());
+    for (size_t i = 0; i < sampleGains.size(); ++i)
+        set->gains[i] = sampleGains[i];
+    
+    for (auto& result : results)
     {
-        auto file = files[i];
-        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor(file));
-        if (reader.get() == nullptr)
+        // an empty sample would end the moment it starts, so the playlist never sees it
+        if (result.sample->getNumSamples() <= 0)
             continue;
         
-        auto sampleLength = static_cast<int>(reader->lengthInSamples);
-        waveformPeaks[i].setSize(1, sampleLength);
-        reader->read (&waveformPeaks[i], 0, sampleLength, 0, true, false);
+        if (result.sample->isStreamed())
+            sampleStreamer.addSource(result.sample.get());
         
-        double speedRatio = reader->sampleRate / getSampleRate();
+        set->samplesSpecs.push_back({ result.ordinal, result.sample.get(), 0, result.sample->getNumSamples() });
+        set->samples.push_back(std::move(result.sample));
+        waveformPeaks[(size_t) result.ordinal] = std::move(result.peaks);
+    }
+    
+    // a reload carries on with the samples after the one that is playing
+    auto firstPosition = 0;
+    if (continuesPlayback)
+        while (firstPosition < (int) set->samplesSpecs.size() && set->samplesSpecs[(size_t) firstPosition].ordinal <= currentOrdinal)
+            ++firstPosition;
+    
+    // the playlist restarts only once the set it indexes into is out, so its entries never queue
+    // up ahead of that set
+    auto numSpecs = (int) set->samplesSpecs.size();
+    publishedSet = set.get();
+    sampleSets.publish(std::move(set));
+    restartPlaylist(numSpecs, firstPosition);
+    loadingProgress = 1.0;
+    
+    sendChangeMessage();
+}
 
-        juce::AudioSampleBuffer readBuffer ((int) reader->numChannels, (int) reader->lengthInSamples);
-        juce::AudioSampleBuffer resampledBuffer ((int) reader->numChannels, (int) (reader->lengthInSamples / speedRatio));
-        
-        reader->read(&readBuffer, 0, (int) reader->lengthInSamples, 0, true, true);
-        
-        juce::LagrangeInterpolator resampler;
-        
-        for (int ch = 0; ch < (int) reader->numChannels; ++ch)
-            resampler.process(speedRatio, readBuffer.getReadPointer(ch), resampledBuffer.getWritePointer(ch), resampledBuffer.getNumSamples());
+void SamplerProcessor::adoptSampleSet()
+{
+    // a replaced set is kept until the voices still playing its samples have faded out
+    if (retiringLength <= 0 || voices.getNumActive() == 0)
+        sampleSets.releasePrevious();
+    
+    auto previousSampleRate = sampleSet != nullptr ? sampleSet->sampleRate : 0.0;
+    
+    auto* set = sampleSets.acquire(true);
+    if (set == sampleSet)
+        return;
+    
+    auto ordinal = currentOrdinal.load();
+    auto position = voices.getPosition(currentVoice);
+    
+    // the outgoing voices fade out while a resumed one fades in, so a reload during playback never clicks
+    auto fadeLength = (juce::int64) (stopFadeSeconds * getSampleRate());
+    voices.fadeOutAll(fadeLength);
+    retiringLength = fadeLength;
+    
+    sampleSet = set;
+    currentVoice = {};
+    currentSampleIndex = -1;
+    playlistPosition = -1;
+    currentOrdinal = -1;
+    
+    if (set != nullptr && set->continuesPlayback && ordinal != -1 && previousSampleRate > 0.0 && transport.getState() == Transport::State::playing)
+        resumeAt(ordinal, (juce::int64) ((double) position * set->sampleRate / previousSampleRate), fadeLength);
+}
+
+void SamplerProcessor::resumeAt(int ordinal, juce::int64 position, juce::int64 fadeInLength)
+{
+    auto& samplesSpecs = sampleSet->samplesSpecs;
+    
+    for (size_t i = 0; i < samplesSpecs.size(); ++i)
+    {
+        if (samplesSpecs[i].ordinal != ordinal)
+            continue;
         
-        SampleSpec sample = { i, samplesBuffer.getNumSamples(), samplesBuffer.getNumSamples() + resampledBuffer.getNumSamples() };
-        samplesBuffer.setSize(getTotalNumOutputChannels(), sample.end, true);
+        currentSampleIndex = (int) i;
+        playlistPosition = (int) i;
+        currentOrdinal = ordinal;
+        startVoice(samplesSpecs[i], juce::jlimit(samplesSpecs[i].start, samplesSpecs[i].end - 1, position), fadeInLength);
+        events.push({ PlaybackEvent::Type::sampleStarted, ordinal });
+        return;
+    }
+}
+
+void SamplerProcessor::play()
+{
+    transport.send(Transport::Command::play);
+}
+
+void SamplerProcessor::stop()
+{
+    transport.send(Transport::Command::stop);
+}
+
+bool SamplerProcessor::isPlaying() const
+{
+    return transport.getState() == Transport::State::playing;
+}
+
+void SamplerProcessor::stopNow()
+{
+    heldNotes.reset();
+    isSustained = false;
+    voices.stopAll();
+    currentVoice = {};
+    
+    if (transport.getState() == Transport::State::stopped)
+        return;
+    
+    transport.apply(Transport::Command::stop);
+    transport.finishStopping();
+    events.push({ PlaybackEvent::Type::transportStopped });
+}
+
+void SamplerProcessor::applyTransportCommand(Transport::Command command)
+{
+    if (command == Transport::Command::play && !hasSamples())
+        return;
+    
+    if (!transport.apply(command))
+        return;
+    
+    switch (transport.getState())
+    {
+        case Transport::State::playing:
+            // MIDI starts playback too, so the editor learns about every start from here
+            events.push({ PlaybackEvent::Type::transportStarted });
+            
+            // playing again before a stop has faded out restarts the sample that was stopped
+            if (currentSampleIndex != -1 && !voices.isActive(currentVoice))
+            {
+                startVoice(sampleSet->samplesSpecs[(size_t) currentSampleIndex], sampleSet->samplesSpecs[(size_t) currentSampleIndex].start);
+                events.push({ PlaybackEvent::Type::sampleStarted, currentOrdinal });
+            }
+            break;
         
-        for (int ch = 0; ch < samplesBuffer.getNumChannels(); ++ch)
-            samplesBuffer.copyFrom(ch, sample.start, resampledBuffer, ch % resampledBuffer.getNumChannels(), 0, resampledBuffer.getNumSamples());
+        case Transport::State::stopping:
+            // the playlist keeps its place, so playing again starts the stopped sample from the top
+            voices.fadeOutAll((juce::int64) (stopFadeSeconds * getSampleRate()));
+            currentVoice = {};
+            break;
         
-        samplesSpecs.push_back(sample);
+        case Transport::State::stopped:
+            break;
     }
-    
-    setIsShuffling(*parameters.getRawParameterValue("shuffle") > 0.5f);
+}
+
+bool SamplerProcessor::hasSamples() const
+{
+    return sampleSet != nullptr && !sampleSet->samplesSpecs.empty();
 }
 
 int SamplerProcessor::getCurrentSampleIndex()
 {
-    if (currentSampleIndex == -1)
-        return currentSampleIndex;
+    return currentOrdinal;
+}
+
+void SamplerProcessor::setSampleGain(int ordinal, float gain)
+{
+    if (!juce::isPositiveAndBelow(ordinal, (int) sampleGains.size()))
+        return;
+    
+    sampleGains[(size_t) ordinal] = gain;
     
-    return samplesSpecs[(size_t) currentSampleIndex].ordinal;
+    if (publishedSet != nullptr && (size_t) ordinal < publishedSet->gains.size())
+        publishedSet->gains[(size_t) ordinal].store(gain, std::memory_order_relaxed);
+}
+
+float SamplerProcessor::getSampleGain(int ordinal) const
+{
+    return juce::isPositiveAndBelow(ordinal, (int) sampleGains.size()) ? sampleGains[(size_t) ordinal] : 1.0f;
 }
 
-void SamplerProcessor::setIsShuffling(bool shouldShuffle)
+void SamplerProcessor::restartPlaylist(int size, int firstPosition)
 {
-    bool wasSuspended = isSuspended();
-    suspendProcessing(true);
+    playlistSize = size;
+    playlist.restart(size, registry.get(playbackOrderParameter), firstPosition);
+}
+
+void SamplerProcessor::renderPlaylist(juce::AudioBuffer<float>& audioBuffer, int startSample, int numSamples)
+{
+    if (numSamples <= 0 || transport.getState() == Transport::State::stopped)
+        return;
     
-    currentSampleIndex = -1;
-    currentPosition = 0;
+    if (transport.getState() == Transport::State::playing && currentSampleIndex == -1 && hasSamples())
+        advanceToNextSample();
+    
+    auto outSamplesRemaining = numSamples;
+    auto outSamplesOffset = startSample;
+    auto numAdvances = 0;
+    
+    // the range is split where the next playlist sample starts, every other voice just keeps sounding,
+    // so a gap is a segment with nothing to render in a buffer that was cleared in one go; past the
+    // advance limit the rest of the range just renders and the playlist carries on next time
+    while (outSamplesRemaining > 0)
+    {
+        auto isPlaying = transport.getState() == Transport::State::playing && currentSampleIndex != -1 && numAdvances < maxAdvancesPerRender;
+        auto outSamplesThisTime = isPlaying ? (int) juce::jlimit((juce::int64) 0, (juce::int64) outSamplesRemaining, getSamplesUntilNext()) : outSamplesRemaining;
+        auto isGapPending = currentLoopMode == LoopMode::Mode::gap && voices.isActive(currentVoice);
+        
+        if (outSamplesThisTime > 0)
+            voices.render(audioBuffer, outSamplesOffset, outSamplesThisTime);
+        
+        retiringLength -= outSamplesThisTime;
+        outSamplesRemaining -= outSamplesThisTime;
+        outSamplesOffset += outSamplesThisTime;
+        
+        if (!isGapPending)
+            nextStartCountdown -= outSamplesThisTime;
+        
+        if (isPlaying && getSamplesUntilNext() <= 0)
+        {
+            ++numAdvances;
+            advanceToNextSample();
+            
+            // the end of the playlist stops without a fade, whatever is still sounding just plays out
+            if (currentSampleIndex == -1)
+                transport.apply(Transport::Command::stop);
+        }
+    }
+}
 
-    if (shouldShuffle)
-        std::shuffle(samplesSpecs.begin(), samplesSpecs.end(), std::mt19937());
+// notes gate the playlist: the first note starts it, every further note moves on to the next sample,
+// and it stops once no note is held and the sustain pedal is up
+void SamplerProcessor::handleMidiMessage(const juce::MidiMessage& message)
+{
+    if (message.isNoteOn())
+    {
+        heldNotes.set((size_t) message.getNoteNumber());
+        
+        if (transport.getState() != Transport::State::playing)
+        {
+            applyTransportCommand(Transport::Command::play);
+        }
+        else if (currentSampleIndex != -1)
+        {
+            advanceToNextSample();
+            if (currentSampleIndex == -1)
+                transport.apply(Transport::Command::stop);
+        }
+    }
+    else if (message.isNoteOff())
+    {
+        heldNotes.reset((size_t) message.getNoteNumber());
+        
+        if (heldNotes.none() && !isSustained)
+            applyTransportCommand(Transport::Command::stop);
+    }
+    else if (message.isSustainPedalOn())
+    {
+        isSustained = true;
+    }
+    else if (message.isSustainPedalOff())
+    {
+        isSustained = false;
+        
+        if (heldNotes.none())
+            applyTransportCommand(Transport::Command::stop);
+    }
+    else if (message.isAllNotesOff() || message.isAllSoundOff())
+    {
+        heldNotes.reset();
+        isSustained = false;
+        applyTransportCommand(Transport::Command::stop);
+    }
+}
+
+void SamplerProcessor::advanceToNextSample()
+{
+    auto& samplesSpecs = sampleSet->samplesSpecs;
+    auto previousVoice = currentVoice;
+    auto crossfadeLength = voices.isActive(previousVoice) ? getCrossfadeLength() : 0;
+    auto wasScheduled = isScheduled(currentLoopMode) && nextStartCountdown <= 0.0;
+    auto remainder = wasScheduled ? juce::jmax(nextStartCountdown, -1.0) : 0.0;
+    auto previousOrdinal = currentOrdinal.load();
+    auto hasWrapped = false;
+    
+    if (isLastSample())
+    {
+        currentSampleIndex = -1;
+    }
     else
-        std::sort(samplesSpecs.begin(), samplesSpecs.end());
+    {
+        // the queue only runs dry before the generator's first time slice after a restart, then play in order
+        auto entry = playlist.pop();
+        auto numSpecs = (int) samplesSpecs.size();
+        
+        if (!juce::isPositiveAndBelow(entry.index, numSpecs))
+            entry = { (currentSampleIndex + 1) % numSpecs, (playlistPosition + 1) % numSpecs };
+        
+        hasWrapped = previousOrdinal != -1 && entry.position == 0;
+        currentSampleIndex = entry.index;
+        playlistPosition = entry.position;
+    }
+    
+    currentOrdinal = (currentSampleIndex == -1 ? -1 : samplesSpecs[(size_t) currentSampleIndex].ordinal);
+    
+    if (currentSampleIndex != -1)
+        startVoice(samplesSpecs[(size_t) currentSampleIndex], samplesSpecs[(size_t) currentSampleIndex].start, crossfadeLength);
+    
+    if (crossfadeLength > 0 && voices.isActive(currentVoice))
+        voices.fadeOut(previousVoice, crossfadeLength);
+    
+    // whatever is left of the previous sample rings out as an ordinary one-shot
+    voices.setStealable(previousVoice, true);
+    
+    // carrying the sub-sample remainder over keeps starts on their exact grid whatever the block size
+    nextStartCountdown += remainder;
     
-    suspendProcessing(wasSuspended);
+    if (previousOrdinal != -1)
+        events.push({ PlaybackEvent::Type::sampleEnded, previousOrdinal });
+    
+    if (hasWrapped)
+        events.push({ PlaybackEvent::Type::playlistWrapped });
+    
+    if (currentOrdinal != -1)
+        events.push({ PlaybackEvent::Type::sampleStarted, currentOrdinal });
 }
 
-void SamplerProcessor::advanceToNextSample()
+void SamplerProcessor::startVoice(const SampleSpec& spec, juce::int64 position, juce::int64 fadeInLength)
 {
-    ++currentSampleIndex;
+    // the playlist voice is never stolen, so overlapping one-shots can only take each other's voices
+    currentVoice = voices.start(spec.sample, &sampleSet->gains[(size_t) spec.ordinal], position, spec.end, false, fadeInLength);
+    
+    // the loop mode and overlap are fixed when a sample starts, so they never jump mid-sample; the overlap
+    // counts output frames like the pool's fades, so both sides of a crossfade last as long at any pitch
+    currentLoopMode = registry.get(loopModeParameter);
+    auto fadeLength = currentLoopMode == LoopMode::Mode::fade ? (juce::int64) (snapshot.get(fadeLengthHandle) * sampleSet->sampleRate) : 0;
+    currentOverlap = juce::jmin(fadeLength, voices.getRemaining(currentVoice) / 2);
+    
+    switch (currentLoopMode)
+    {
+        case LoopMode::Mode::none:
+        case LoopMode::Mode::fade:
+            nextStartCountdown = 0.0;
+            break;
+        
+        case LoopMode::Mode::trigger:
+            nextStartCountdown = sampleSet->sampleRate / snapshot.get(triggerRateHandle) - (double) (position - spec.start);
+            break;
+        
+        case LoopMode::Mode::gap:
+            // counted down only once the sample has played out, however its speed changes on the way
+            nextStartCountdown = snapshot.get(gapLengthHandle) * sampleSet->sampleRate;
+            break;
+    }
+}
+
+bool SamplerProcessor::isScheduled(LoopMode::Mode mode)
+{
+    return mode == LoopMode::Mode::trigger || mode == LoopMode::Mode::gap;
+}
 
-    if (currentSampleIndex >= (int) samplesSpecs.size())
+bool SamplerProcessor::isLastSample() const
+{
+    return currentSampleIndex != -1 && playlistPosition + 1 >= (int) sampleSet->samplesSpecs.size() && !snapshot.isOn(loopHandle);
+}
+
+juce::int64 SamplerProcessor::getCrossfadeLength() const
+{
+    return isLastSample() ? 0 : currentOverlap;
+}
+
+juce::int64 SamplerProcessor::getSamplesUntilNext() const
+{
+    auto remaining = voices.isActive(currentVoice) ? voices.getRemaining(currentVoice) : 0;
+    
+    // the last sample of a playlist that doesn't loop always plays to its end
+    if (isLastSample())
+        return remaining;
+    
+    switch (currentLoopMode)
     {
-        if (*parameters.getRawParameterValue("shuffle") > 0.5f)
-            std::shuffle(samplesSpecs.begin(), samplesSpecs.end(), std::mt19937());
+        case LoopMode::Mode::none:
+        case LoopMode::Mode::fade:
+            return remaining - currentOverlap;
         
-        currentSampleIndex = (*parameters.getRawParameterValue("loop") > 0.5f ? 0 : -1);
+        case LoopMode::Mode::trigger:
+            return (juce::int64) std::ceil(nextStartCountdown);
+        
+        case LoopMode::Mode::gap:
+            return remaining > 0 ? remaining : (juce::int64) std::ceil(nextStartCountdown);
     }
     
-    currentPosition = (currentSampleIndex == -1 ? 0 : samplesSpecs[(size_t) currentSampleIndex].start);
-
-    sendChangeMessage();
+    return remaining;
 }
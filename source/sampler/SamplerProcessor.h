@@ -3,10 +3,20 @@
 #include <juce_audio_formats/juce_audio_formats.h>
 #include <juce_audio_devices/juce_audio_devices.h>
 #include "ProcessorBase.h"
+#include "parameters/ParameterRegistry.h"
+#include "parameters/ParameterSnapshot.h"
 #include "SamplerUtils.h"
+#include "sampler/PlaylistGenerator.h"
+#include "sampler/SampleLoader.h"
+#include "sampler/SampleStreamer.h"
+#include "sampler/Transport.h"
+#include "sampler/VoicePool.h"
+#include "utils/AtomicHandoff.h"
+#include "utils/EventFifo.h"
+#include <bitset>
 
 
-class SamplerProcessor : public ProcessorBase, juce::AudioProcessorValueTreeState::Listener
+class SamplerProcessor : public ProcessorBase, private juce::Timer
 {
 public:
     SamplerProcessor();
@@ -20,35 +30,137 @@ public:
     juce::AudioProcessorEditor* createEditor() override;
     juce::AudioProcessorParameter* getBypassParameter() const override;
     const juce::String getName() const override;
+    bool acceptsMidi() const override { return true; }
     
-    void parameterChanged (const juce::String& parameterID, float newValue) override;
+    // what the audio thread reports as it plays, a sample is identified by its file index
+    struct PlaybackEvent
+    {
+        enum class Type { sampleStarted, sampleEnded, playlistWrapped, transportStarted, transportStopped };
+        
+        Type type = Type::sampleStarted;
+        int ordinal = -1;
+    };
+    
+    // message thread, and only ever from one place at a time: the queue has a single reader
+    template <typename Callback>
+    int drainEvents(Callback&& callback) { return events.drain(std::forward<Callback>(callback)); }
 
+    // any thread but the audio thread, the change takes effect at the start of the next block
+    void play();
+    void stop();
+    bool isPlaying() const;
+    
+    // audio thread, between blocks: ends playback without a fade and forgets held notes
+    void stopNow();
+    
     int getCurrentSampleIndex();
     void readFiles(juce::Array<juce::File>& files);
-    const std::vector<juce::AudioBuffer<float>>& getWaveformPeaks() const { return waveformPeaks; }
+    bool isLoading() const { return sampleLoader.isLoading(); }
+    double& getLoadingProgress() { return loadingProgress; }
+    const std::vector<std::shared_ptr<const WaveformPeaks>>& getWaveformPeaks() const { return waveformPeaks; }
+    
+    // per-sound gain by file index, set from the file list and applied smoothly while rendering so it can change at any time
+    void setSampleGain(int ordinal, float gain);
+    float getSampleGain(int ordinal) const;
     
 private:
     struct SampleSpec
     {
         int ordinal;
-        int start;
-        int end;
-        float gain = 1.0;
+        const Sample* sample;
+        juce::int64 start;
+        juce::int64 end;
         bool bypass = false;
-        bool operator < (const SampleSpec& rhs) const { return start < rhs.start; }
     };
     
+    struct SampleSet
+    {
+        explicit SampleSet(SampleStreamer& s) : streamer(s) {}
+        ~SampleSet();
+        
+        SampleStreamer& streamer;
+        std::vector<std::shared_ptr<const Sample>> samples;
+        std::vector<SampleSpec> samplesSpecs;
+        std::vector<std::atomic<float>> gains;
+        double sampleRate = 0.0;
+        bool continuesPlayback = false;
+    };
+    
+    enum class Storage { float32, int24, int16 };
+    static constexpr char const *storageLabels[] = { "32-bit float", "24-bit", "16-bit", nullptr };
+    
+    // every parameter is defined here, the value tree owns them for the editor's attachments
+    // and the snapshot reads the smoothed ones, choices are read through their typed handles
+    ParameterRegistry registry;
+    const ParameterHandle<bool> bypassParameter, loopParameter;
+    const ParameterHandle<PlaybackOrder::Order> playbackOrderParameter;
+    const ParameterHandle<float> pitchParameter, levelParameter;
+    const ParameterHandle<LoopMode::Mode> loopModeParameter;
+    const ParameterHandle<float> fadeLengthParameter, triggerRateParameter, gapLengthParameter;
+    const ParameterHandle<Storage> storageParameter;
+    const ParameterHandle<VoicePool::Stealing> stealingParameter;
+    const ParameterHandle<VarispeedInterpolator::Type> interpolationParameter;
     juce::AudioProcessorValueTreeState parameters;
+    
+    ParameterSnapshot snapshot;
+    const ParameterSnapshot::Handle bypassHandle, pitchHandle, loopHandle, fadeLengthHandle, triggerRateHandle, gapLengthHandle, levelHandle;
     juce::AudioFormatManager formatManager;
-    juce::AudioSampleBuffer samplesBuffer;
-    std::vector<SampleSpec> samplesSpecs;
+    juce::SharedResourcePointer<SampleCache> sampleCache;
+    juce::SharedResourcePointer<SamplePool> samplePool;
+    // after the cache and the pool, which its jobs use until the loader has waited for them
+    SampleLoader sampleLoader { formatManager };
+    SampleStreamer sampleStreamer { formatManager, VoicePool::maxStreams, 2 };
+    VoicePool voices { sampleStreamer };
+    PlaylistGenerator playlist;
+    std::atomic<int> playlistSize { 0 };
+    double loadingProgress = 0.0;
+    
+    // kept so the library can be reloaded in the background when the host rate or storage changes
+    juce::Array<juce::File> loadedFiles;
+    double loadedSampleRate = 0.0;
+    bool isReloading = false;
+    std::atomic<bool> storageChanged { false };
+    std::atomic<bool> sampleRateChanged { false };
+    std::atomic<double> preparedSampleRate { 0.0 };
+    
+    AtomicHandoff<SampleSet> sampleSets;
+    SampleSet* sampleSet = nullptr;
+    SampleSet* publishedSet = nullptr;
+    // output frames until the voices of the set replaced last have faded out
+    juce::int64 retiringLength = 0;
+    std::vector<float> sampleGains;
 
-    int currentPosition = 0;
+    VoicePool::VoiceId currentVoice;
+    juce::int64 currentOverlap = 0;
+    LoopMode::Mode currentLoopMode = LoopMode::Mode::none;
+    double nextStartCountdown = 0.0;
     int currentSampleIndex = -1;
+    int playlistPosition = -1;
+    std::atomic<int> currentOrdinal { -1 };
+    EventFifo<PlaybackEvent, 256> events;
+    Transport transport;
+    std::bitset<128> heldNotes;
+    bool isSustained = false;
+    void adoptSampleSet();
+    void applyTransportCommand(Transport::Command command);
+    bool hasSamples() const;
+    void renderPlaylist(juce::AudioBuffer<float>& audioBuffer, int startSample, int numSamples);
+    void handleMidiMessage(const juce::MidiMessage& message);
     void advanceToNextSample();
-    void setIsShuffling(bool shouldShuffle);
+    void resumeAt(int ordinal, juce::int64 position, juce::int64 fadeInLength);
+    void startVoice(const SampleSpec& spec, juce::int64 position, juce::int64 fadeInLength = 0);
+    static bool isScheduled(LoopMode::Mode mode);
+    bool isLastSample() const;
+    juce::int64 getCrossfadeLength() const;
+    juce::int64 getSamplesUntilNext() const;
+    void restartPlaylist(int size, int firstPosition = 0);
+    void loadFiles(double sampleRate);
+    Sample::Encoding getStorageEncoding() const;
+    void publishSamples(SampleLoader::Results results, bool continuesPlayback);
+    
+    std::vector<std::shared_ptr<const WaveformPeaks>> waveformPeaks;
+    
+    void timerCallback() override;
     
-    std::vector<juce::AudioBuffer<float>> waveformPeaks;
-        
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SamplerProcessor)
 };
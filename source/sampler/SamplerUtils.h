@@ -46,14 +46,3 @@ private:
     Order order;
 };
 
-#pragma mark -
-
-template <typename I>
-size_t index_of(I first, I last, typename std::iterator_traits<I>::value_type val)
-{
-    size_t i = 0;
-    while (first != last && *first != val)
-        ++first; ++i;
-    return i;
-}
-
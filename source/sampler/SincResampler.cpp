@@ -0,0 +1,197 @@
+
+#include "SincResampler.h"
+
+#if defined (__AVX__) || defined (__SSE__) || defined (_M_X64) || defined (_M_AMD64)
+ #include <immintrin.h>
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+ #include <arm_neon.h>
+#endif
+
+
+// taps are padded to a whole number of the widest registers used below
+static constexpr int tapAlignment = 8;
+
+struct FilterDesign
+{
+    int numPhases;
+    int baseTaps;       // kernel length when not downsampling
+    double rolloff;     // passband edge relative to the lower Nyquist
+    double beta;        // Kaiser window shape
+    bool interpolatesPhases;
+};
+
+static FilterDesign getDesign(SincResampler::Quality quality)
+{
+    switch (quality)
+    {
+        case SincResampler::Quality::draft:     return { 64, 12, 0.80, 6.0, false };
+        case SincResampler::Quality::mastering: return { 1024, 160, 0.95, 10.0, true };
+        case SincResampler::Quality::standard:  break;
+    }
+    
+    return { 256, 64, 0.90, 8.0, true };
+}
+
+static double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    
+    for (int k = 1; k < 50 && term > sum * 1.0e-12; ++k)
+    {
+        term *= (x * x) / (4.0 * k * k);
+        sum += term;
+    }
+    
+    return sum;
+}
+
+static float dot(const float* a, const float* b, int numValues)
+{
+   #if defined (__AVX__)
+    auto sum = _mm256_setzero_ps();
+    for (int i = 0; i < numValues; i += 8)
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    
+    auto half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    return _mm_cvtss_f32(_mm_add_ss(half, _mm_shuffle_ps(half, half, 1)));
+   #elif defined (__SSE__) || defined (_M_X64) || defined (_M_AMD64)
+    auto sum = _mm_setzero_ps();
+    for (int i = 0; i < numValues; i += 4)
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    return _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1)));
+   #elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+    auto sum = vdupq_n_f32(0.0f);
+    for (int i = 0; i < numValues; i += 4)
+        sum = vmlaq_f32(sum, vld1q_f32(a + i), vld1q_f32(b + i));
+    
+    auto pair = vadd_f32(vget_high_f32(sum), vget_low_f32(sum));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+   #else
+    float sum = 0.0f;
+    for (int i = 0; i < numValues; ++i)
+        sum += a[i] * b[i];
+    
+    return sum;
+   #endif
+}
+
+#pragma mark -
+
+SincResampler::SincResampler(double sampleRatio, Quality quality)
+    : ratio(sampleRatio)
+{
+    jassert(ratio > 0.0);
+    
+    auto design = getDesign(quality);
+    numPhases = design.numPhases;
+    interpolatesPhases = design.interpolatesPhases;
+    
+    // when downsampling the cutoff follows the destination Nyquist and the kernel widens with it
+    auto cutoff = juce::jmin(1.0, 1.0 / ratio) * design.rolloff;
+    numTaps = (int) std::ceil(design.baseTaps / cutoff / tapAlignment) * tapAlignment;
+    
+    table.malloc((size_t) (numPhases + 1) * (size_t) numTaps);
+    kernel.malloc(numTaps);
+    window.malloc(numTaps);
+    
+    fillKernelTable(table, numPhases, numTaps, cutoff, design.beta);
+}
+
+void SincResampler::fillKernelTable(float* table, int numPhases, int numTaps, double cutoff, double beta)
+{
+    auto halfTaps = numTaps / 2;
+    auto windowScale = 1.0 / besselI0(beta);
+    
+    for (int phase = 0; phase <= numPhases; ++phase)
+    {
+        auto* taps = table + phase * numTaps;
+        auto fraction = (double) phase / numPhases;
+        auto sum = 0.0;
+        
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            auto distance = tap - halfTaps + 1 - fraction;
+            auto x = distance / halfTaps;
+            auto w = besselI0(beta * std::sqrt(juce::jmax(0.0, 1.0 - x * x))) * windowScale;
+            auto arg = juce::MathConstants<double>::pi * cutoff * distance;
+            auto h = std::abs(arg) < 1.0e-9 ? cutoff : cutoff * std::sin(arg) / arg;
+            
+            taps[tap] = (float) (h * w);
+            sum += h * w;
+        }
+        
+        juce::FloatVectorOperations::multiply(taps, (float) (1.0 / sum), numTaps);
+    }
+}
+
+juce::int64 SincResampler::getNumOutputSamples(juce::int64 numInputSamples) const
+{
+    return (juce::int64) ((double) numInputSamples / ratio);
+}
+
+juce::int64 SincResampler::getFirstInputFrame(juce::int64 outputFrame) const
+{
+    return (juce::int64) ((double) outputFrame * ratio) - numTaps / 2 + 1;
+}
+
+juce::int64 SincResampler::getLastInputFrame(juce::int64 outputFrame) const
+{
+    return getFirstInputFrame(outputFrame) + numTaps - 1;
+}
+
+void SincResampler::process(const juce::AudioSampleBuffer& source, juce::int64 firstFrame, float* const* dest, int numFrames)
+{
+    process(source, 0, source.getNumSamples(), firstFrame, dest, numFrames);
+}
+
+void SincResampler::process(const juce::AudioSampleBuffer& source, juce::int64 sourceStart, int sourceLength, juce::int64 firstFrame, float* const* dest, int numFrames)
+{
+    for (int i = 0; i < numFrames; ++i)
+    {
+        auto position = (double) (firstFrame + i) * ratio;
+        auto index = (juce::int64) position;
+        auto* taps = getKernel(position - (double) index);
+        
+        auto first = getFirstInputFrame(firstFrame + i) - sourceStart;
+        auto isInside = first >= 0 && first + numTaps <= sourceLength;
+        
+        for (int ch = 0; ch < source.getNumChannels(); ++ch)
+        {
+            auto* input = source.getReadPointer(ch);
+            
+            if (isInside)
+            {
+                dest[ch][i] = dot(taps, input + first, numTaps);
+                continue;
+            }
+            
+            for (int tap = 0; tap < numTaps; ++tap)
+            {
+                auto s = first + tap;
+                window[tap] = (s >= 0 && s < sourceLength) ? input[s] : 0.0f;
+            }
+            
+            dest[ch][i] = dot(taps, window, numTaps);
+        }
+    }
+}
+
+const float* SincResampler::getKernel(double fraction)
+{
+    auto phase = fraction * numPhases;
+    
+    if (!interpolatesPhases)
+        return table + juce::roundToInt(phase) * numTaps;
+    
+    auto lower = juce::jmin((int) phase, numPhases - 1);
+    auto weight = (float) (phase - lower);
+    auto* taps = table + lower * numTaps;
+    
+    juce::FloatVectorOperations::copyWithMultiply(kernel, taps, 1.0f - weight, numTaps);
+    juce::FloatVectorOperations::addWithMultiply(kernel, taps + numTaps, weight, numTaps);
+    
+    return kernel;
+}
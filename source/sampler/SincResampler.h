@@ -0,0 +1,51 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "models/ResamplingQuality.h"
+
+
+// Windowed-sinc resampler used while loading samples. The Kaiser windowed kernel is
+// tabulated as a polyphase filter bank; for every output frame one kernel is picked,
+// or blended between neighbouring phases, and then applied to all channels with
+// dot products vectorised for AVX, SSE or NEON.
+class SincResampler final
+{
+public:
+    using Quality = ResamplingQuality;
+    
+    // ratio is source rate over destination rate, as for juce::LagrangeInterpolator
+    SincResampler(double ratio, Quality quality);
+    
+    // Fills numPhases + 1 rows of numTaps Kaiser windowed sinc taps, row p for a fraction of p / numPhases
+    // and each normalised to unity gain at DC. Tap t weighs the frame t - numTaps / 2 + 1 away from the
+    // frame at or before the position. Also used by VarispeedInterpolator for its short kernel.
+    static void fillKernelTable(float* table, int numPhases, int numTaps, double cutoff, double beta);
+    
+    juce::int64 getNumOutputSamples(juce::int64 numInputSamples) const;
+    int getNumTaps() const { return numTaps; }
+    
+    // the source frames output frame n is computed from
+    juce::int64 getFirstInputFrame(juce::int64 outputFrame) const;
+    juce::int64 getLastInputFrame(juce::int64 outputFrame) const;
+    
+    // Writes output frames [firstFrame, firstFrame + numFrames) of every source channel.
+    // Frames outside the source count as silence, so any range can be rendered on its own.
+    void process(const juce::AudioSampleBuffer& source, juce::int64 firstFrame, float* const* dest, int numFrames);
+    
+    // As above, with source holding only the sourceLength frames starting at sourceStart.
+    void process(const juce::AudioSampleBuffer& source, juce::int64 sourceStart, int sourceLength, juce::int64 firstFrame, float* const* dest, int numFrames);
+    
+private:
+    const double ratio;
+    int numPhases;
+    int numTaps;
+    bool interpolatesPhases;
+    
+    juce::HeapBlock<float> table;
+    juce::HeapBlock<float> kernel;
+    juce::HeapBlock<float> window;
+    
+    const float* getKernel(double fraction);
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SincResampler)
+};
@@ -0,0 +1,41 @@
+
+#include "Transport.h"
+
+
+bool Transport::send(Command command)
+{
+    // the queue takes one producer at a time
+    const juce::SpinLock::ScopedLockType lock(sendLock);
+    return commands.push(command);
+}
+
+bool Transport::apply(Command command)
+{
+    auto current = state.load(std::memory_order_relaxed);
+    auto next = current;
+    
+    switch (command)
+    {
+        case Command::play:
+            next = State::playing;
+            break;
+        
+        case Command::stop:
+            next = current == State::playing ? State::stopping : current;
+            break;
+    }
+    
+    state.store(next, std::memory_order_release);
+    return next != current;
+}
+
+void Transport::finishStopping()
+{
+    if (state.load(std::memory_order_relaxed) == State::stopping)
+        state.store(State::stopped, std::memory_order_release);
+}
+
+Transport::State Transport::getState() const
+{
+    return state.load(std::memory_order_acquire);
+}
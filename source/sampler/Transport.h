@@ -0,0 +1,38 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "utils/EventFifo.h"
+
+
+// Play and stop for the sampler without touching the processor callback lock. Any thread other than
+// the audio thread sends commands, which the audio thread applies at the start of its next block;
+// the audio thread drives its own transitions, like reaching the end of the playlist, directly.
+// The editor, reset() and the host's prepareToPlay() may all send at once, so senders take turns
+// on a spin lock the audio thread never touches. Stopping lasts until the last voice has faded
+// out, so the state can be read from anywhere.
+class Transport final
+{
+public:
+    enum class State { stopped, playing, stopping };
+    enum class Command { play, stop };
+    
+    // any thread but the audio thread: only waits for another sender, returns false if the audio
+    // thread has fallen a whole queue behind
+    bool send(Command command);
+    
+    // audio thread: hands every queued command to the callback, which usually just applies it,
+    // and returns how many there were
+    template <typename Callback>
+    int handleCommands(Callback&& callback) { return commands.drain(std::forward<Callback>(callback)); }
+    
+    // audio thread: returns true if the command changed the state
+    bool apply(Command command);
+    void finishStopping();
+    
+    State getState() const;
+    
+private:
+    EventFifo<Command, 32> commands;
+    juce::SpinLock sendLock;
+    std::atomic<State> state { State::stopped };
+};
@@ -0,0 +1,91 @@
+
+#include "VarispeedInterpolator.h"
+#include "SincResampler.h"
+
+
+static constexpr int sincTaps = VarispeedInterpolator::lookBehind + VarispeedInterpolator::lookAhead + 1;
+static constexpr int sincPhases = 256;
+
+// the shared kernel puts the frame at or before the position at tap numTaps / 2 - 1
+static_assert(VarispeedInterpolator::lookBehind == sincTaps / 2 - 1);
+
+// rows of the loader's Kaiser windowed sinc, cut down to a length that runs per voice on the audio thread
+static const std::vector<float> sincTable = []
+{
+    std::vector<float> table ((size_t) (sincPhases + 1) * sincTaps);
+    SincResampler::fillKernelTable(table.data(), sincPhases, sincTaps, 0.9, 6.0);
+    return table;
+}();
+
+void VarispeedInterpolator::prepare(int maximumBlockSize)
+{
+    indices.malloc((size_t) maximumBlockSize);
+    fractions.malloc((size_t) maximumBlockSize);
+}
+
+double VarispeedInterpolator::setPositions(double position, float startStep, float endStep, int numFrames)
+{
+    // closed form of a step that ramps linearly, so no frame depends on the one before
+    auto delta = (double) (endStep - startStep) / juce::jmax(1, numFrames);
+    
+    for (int i = 0; i < numFrames; ++i)
+    {
+        auto framePosition = position + i * (double) startStep + 0.5 * i * (i - 1) * delta;
+        auto index = std::floor(framePosition);
+        
+        indices[i] = (int) index;
+        fractions[i] = (float) (framePosition - index);
+    }
+    
+    numPositions = numFrames;
+    return position + numFrames * (double) startStep + 0.5 * numFrames * (numFrames - 1) * delta;
+}
+
+void VarispeedInterpolator::process(Type type, const float* source, float* dest) const
+{
+    switch (type)
+    {
+        case Type::cubic: processCubic(source, dest); return;
+        case Type::sinc:  processSinc(source, dest); return;
+    }
+}
+
+#pragma mark -
+
+void VarispeedInterpolator::processCubic(const float* source, float* dest) const
+{
+    for (int i = 0; i < numPositions; ++i)
+    {
+        auto* x = source + indices[i];
+        auto f = fractions[i];
+        
+        auto c1 = 0.5f * (x[1] - x[-1]);
+        auto c2 = x[-1] - 2.5f * x[0] + 2.0f * x[1] - 0.5f * x[2];
+        auto c3 = 0.5f * (x[2] - x[-1]) + 1.5f * (x[0] - x[1]);
+        
+        dest[i] = ((c3 * f + c2) * f + c1) * f + x[0];
+    }
+}
+
+void VarispeedInterpolator::processSinc(const float* source, float* dest) const
+{
+    for (int i = 0; i < numPositions; ++i)
+    {
+        auto* x = source + indices[i] - lookBehind;
+        auto phase = fractions[i] * sincPhases;
+        auto row = juce::jmin(sincPhases - 1, (int) phase);
+        auto mix = phase - (float) row;
+        
+        auto* lower = sincTable.data() + row * sincTaps;
+        auto* upper = lower + sincTaps;
+        
+        float lowerSum = 0.0f, upperSum = 0.0f;
+        for (int tap = 0; tap < sincTaps; ++tap)
+        {
+            lowerSum += lower[tap] * x[tap];
+            upperSum += upper[tap] * x[tap];
+        }
+        
+        dest[i] = lowerSum + mix * (upperSum - lowerSum);
+    }
+}
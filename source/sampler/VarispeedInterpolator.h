@@ -0,0 +1,32 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+
+// Reads a block of source frames at fractional positions whose step changes linearly across the block.
+// The positions are laid out once per block, then every channel is interpolated from them in a loop with
+// no carried state, so the per-frame work is independent and left to the compiler to vectorise.
+class VarispeedInterpolator final
+{
+public:
+    enum class Type { cubic, sinc };
+    static constexpr char const *labels[] = { "Cubic", "Sinc", nullptr };
+    
+    // frames the kernels read either side of the frame at or before each position
+    static constexpr int lookBehind = 3;
+    static constexpr int lookAhead = 4;
+    
+    void prepare(int maximumBlockSize);
+    
+    // returns the position one step past the last frame, which is where the next block starts
+    double setPositions(double position, float startStep, float endStep, int numFrames);
+    void process(Type type, const float* source, float* dest) const;
+    
+private:
+    juce::HeapBlock<int> indices;
+    juce::HeapBlock<float> fractions;
+    int numPositions = 0;
+    
+    void processCubic(const float* source, float* dest) const;
+    void processSinc(const float* source, float* dest) const;
+};
@@ -0,0 +1,557 @@
+
+#include "VoicePool.h"
+
+
+// a quarter sine, read forwards to fade in and backwards to fade out, so overlapping fades sum to constant power
+static constexpr int fadeTableSize = 1024;
+static const std::array<float, fadeTableSize + 1> fadeTable = []
+{
+    std::array<float, fadeTableSize + 1> table;
+    for (size_t i = 0; i < table.size(); ++i)
+        table[i] = (float) std::sin(juce::MathConstants<double>::halfPi * (double) i / fadeTableSize);
+    return table;
+}();
+
+static float lookupFade(double proportion)
+{
+    auto index = juce::jlimit(0.0, 1.0, proportion) * fadeTableSize;
+    auto first = juce::jlimit(0, fadeTableSize - 1, (int) index);
+    auto fraction = (float) (index - first);
+    return fadeTable[(size_t) first] + fraction * (fadeTable[(size_t) first + 1] - fadeTable[(size_t) first]);
+}
+
+VoicePool::VoicePool(SampleStreamer& sampleStreamer)
+    : streamer(sampleStreamer)
+{
+}
+
+void VoicePool::prepare(double sampleRate, int numChannels, int maximumBlockSize)
+{
+    for (auto& voice : voices)
+    {
+        voice.gain.reset(sampleRate, 0.02);
+        voice.speed.reset(sampleRate, 0.05);
+    }
+    
+    jassert (numChannels <= maxChannels);
+    numChannels = juce::jmin(numChannels, maxChannels);
+    
+    scratch.setSize(numChannels, maximumBlockSize);
+    window.setSize(numChannels, historyLength + (int) std::ceil(maximumBlockSize * maxSpeed) + VarispeedInterpolator::lookAhead + 2);
+    envelope.malloc((size_t) maximumBlockSize);
+    shortFadeLength = juce::jmax((juce::int64) 1, (juce::int64) (0.01 * sampleRate));
+    interpolator.prepare(maximumBlockSize);
+}
+
+void VoicePool::setStealing(Stealing policy)
+{
+    stealing = policy;
+}
+
+void VoicePool::setSpeed(float speed)
+{
+    targetSpeed = juce::jlimit(1.0f / maxSpeed, maxSpeed, speed);
+}
+
+void VoicePool::setInterpolation(VarispeedInterpolator::Type type)
+{
+    interpolation = type;
+}
+
+#pragma mark -
+
+VoicePool::VoiceId VoicePool::start(const Sample* sample, const std::atomic<float>* gain, juce::int64 startPosition, juce::int64 end, bool stealable, juce::int64 fadeInLength)
+{
+    if (sample == nullptr || startPosition >= end)
+        return {};
+    
+    if (numActive - numStolen >= maxVoices)
+    {
+        auto victim = findVictim(false);
+        if (victim == -1)
+            return {};
+        
+        steal(voices[(size_t) activeVoices[(size_t) victim]], {});
+    }
+    
+    // with the reserve full of stolen voices still fading, the one closest to silence is cut
+    if (numActive == numSlots)
+        release(findShortestStolen());
+    
+    auto index = -1;
+    for (int i = 0; i < numSlots && index == -1; ++i)
+        if (voices[(size_t) i].sample == nullptr)
+            index = i;
+    
+    activeVoices[(size_t) numActive++] = index;
+    
+    auto& voice = voices[(size_t) index];
+    voice.sample = sample;
+    voice.gainSource = gain;
+    voice.gain.setCurrentAndTargetValue(gain != nullptr ? gain->load(std::memory_order_relaxed) : 1.0f);
+    voice.speed.setCurrentAndTargetValue(targetSpeed);
+    voice.position = startPosition;
+    voice.fraction = 0.0;
+    voice.fetchPosition = startPosition;
+    voice.isVarispeed = false;
+    voice.history.fill(0.0f);
+    voice.end = end;
+    voice.fadeInElapsed = 0;
+    voice.fadeOutRemaining = -1;
+    voice.fadeInLength = juce::jlimit((juce::int64) 0, getRemaining(voice), fadeInLength);
+    voice.startOrder = numStarted++;
+    voice.level = 0.0f;
+    voice.stream = -1;
+    voice.stealable = stealable;
+    voice.isStolen = false;
+    ++voice.generation;
+    
+    if (sample->isStreamed() && end > sample->getResidentLength() && !startStream(index))
+    {
+        // with every stream taken by voices that can't be stolen, only the resident head can play
+        voice.end = sample->getResidentLength();
+        
+        if (voice.position >= voice.end)
+        {
+            stop({ index, voice.generation });
+            return {};
+        }
+        
+        voice.fadeInLength = juce::jmin(voice.fadeInLength, getRemaining(voice));
+        beginFadeOut(voice, juce::jmin(getRemaining(voice), shortFadeLength));
+    }
+    
+    return { index, voice.generation };
+}
+
+bool VoicePool::startStream(int index)
+{
+    auto& voice = voices[(size_t) index];
+    auto stream = (int) std::distance(streamsInUse.begin(), std::find(streamsInUse.begin(), streamsInUse.end(), false));
+    
+    // a streamed voice can't play on without its stream, so the one that gives it up is stolen and hands
+    // it over once it has faded out; until then the new voice plays from its resident head
+    if (stream == maxStreams)
+    {
+        for (int i = 0; i < numActive; ++i)
+        {
+            auto& other = voices[(size_t) activeVoices[(size_t) i]];
+            
+            if (other.isStolen && other.stream != -1 && find(other.streamHeir) == nullptr)
+            {
+                other.streamHeir = { index, voice.generation };
+                return true;
+            }
+        }
+        
+        auto victim = findVictim(true);
+        if (victim == -1)
+            return false;
+        
+        steal(voices[(size_t) activeVoices[(size_t) victim]], { index, voice.generation });
+        return true;
+    }
+    
+    streamsInUse[(size_t) stream] = true;
+    voice.stream = stream;
+    streamer.start(stream, voice.sample, juce::jmax(voice.position, voice.sample->getResidentLength()));
+    return true;
+}
+
+void VoicePool::stop(VoiceId id)
+{
+    for (int i = 0; i < numActive; ++i)
+    {
+        if (activeVoices[(size_t) i] == id.index && voices[(size_t) id.index].generation == id.generation)
+        {
+            release(i);
+            return;
+        }
+    }
+}
+
+void VoicePool::setStealable(VoiceId id, bool stealable)
+{
+    if (auto* voice = find(id))
+        voice->stealable = stealable;
+}
+
+void VoicePool::fadeOut(VoiceId id, juce::int64 length)
+{
+    if (auto* voice = find(id))
+        beginFadeOut(*voice, length);
+}
+
+void VoicePool::fadeOutAll(juce::int64 length)
+{
+    for (int i = 0; i < numActive; ++i)
+    {
+        auto& voice = voices[(size_t) activeVoices[(size_t) i]];
+        
+        if (getRemaining(voice) > length)
+            beginFadeOut(voice, length);
+    }
+}
+
+void VoicePool::stopAll()
+{
+    while (numActive > 0)
+        release(numActive - 1);
+}
+
+#pragma mark -
+
+bool VoicePool::isActive(VoiceId id) const
+{
+    return find(id) != nullptr;
+}
+
+juce::int64 VoicePool::getPosition(VoiceId id) const
+{
+    auto* voice = find(id);
+    return voice != nullptr ? voice->position : 0;
+}
+
+juce::int64 VoicePool::getRemaining(VoiceId id) const
+{
+    auto* voice = find(id);
+    return voice != nullptr ? getRemaining(*voice) : 0;
+}
+
+int VoicePool::getNumActive() const
+{
+    return numActive;
+}
+
+#pragma mark -
+
+void VoicePool::render(juce::AudioBuffer<float>& output, int startSample, int numSamples)
+{
+    auto maxLength = scratch.getNumSamples();
+    if (maxLength == 0)
+        return;
+    
+    for (int offset = 0; offset < numSamples; offset += maxLength)
+    {
+        auto numThisTime = juce::jmin(maxLength, numSamples - offset);
+        
+        // released voices are swapped in from the end, which has already been rendered
+        for (int i = numActive - 1; i >= 0; --i)
+        {
+            auto& voice = voices[(size_t) activeVoices[(size_t) i]];
+            renderVoice(voice, output, startSample + offset, numThisTime);
+            
+            if (voice.position >= voice.end || voice.fadeOutRemaining == 0)
+                release(i);
+        }
+    }
+}
+
+void VoicePool::renderVoice(Voice& voice, juce::AudioBuffer<float>& output, int startSample, int numSamples)
+{
+    auto numChannels = juce::jmin(output.getNumChannels(), scratch.getNumChannels());
+    
+    if (voice.gainSource != nullptr)
+        voice.gain.setTargetValue(voice.gainSource->load(std::memory_order_relaxed));
+    
+    voice.speed.setTargetValue(targetSpeed);
+    
+    if (!voice.isVarispeed && (voice.speed.isSmoothing() || !juce::approximatelyEqual(targetSpeed, 1.0f)))
+        beginVarispeed(voice);
+    
+    if (voice.fadeOutRemaining >= 0)
+        numSamples = (int) juce::jmin((juce::int64) numSamples, voice.fadeOutRemaining);
+    
+    auto numFrames = voice.isVarispeed ? renderVarispeed(voice, numSamples) : renderDirect(voice, numSamples);
+    
+    applyFades(voice, numFrames);
+    voice.fadeInElapsed += numFrames;
+    
+    if (voice.fadeOutRemaining >= 0)
+        voice.fadeOutRemaining -= numFrames;
+    
+    for (int ch = 0; ch < numChannels; ++ch)
+        output.addFrom(ch, startSample, scratch, ch, 0, numFrames);
+    
+    voice.level = scratch.getMagnitude(0, numFrames);
+}
+
+int VoicePool::renderDirect(Voice& voice, int numSamples)
+{
+    auto* sample = voice.sample;
+    auto numFrames = (int) juce::jmin((juce::int64) numSamples, voice.end - voice.position);
+    auto numResident = (int) juce::jlimit((juce::int64) 0, (juce::int64) numFrames, sample->getResidentLength() - voice.position);
+    
+    auto startGain = voice.gain.getCurrentValue();
+    auto residentGain = numResident > 0 ? voice.gain.skip(numResident) : startGain;
+    
+    if (numResident > 0)
+        for (int ch = 0; ch < scratch.getNumChannels(); ++ch)
+            sample->read(ch % sample->getNumChannels(), voice.position, scratch.getWritePointer(ch), numResident, startGain, residentGain);
+    
+    if (numResident < numFrames)
+    {
+        auto numStreamed = numFrames - numResident;
+        auto streamedGain = voice.gain.skip(numStreamed);
+        auto numRead = voice.stream != -1 ? streamer.read(voice.stream, scratch, numResident, numStreamed, residentGain, streamedGain) : 0;
+        
+        if (numRead < numStreamed)
+            scratch.clear(numResident + numRead, numStreamed - numRead);
+        
+        keepStreamedHistory(voice, numResident, numStreamed);
+    }
+    
+    voice.position += numFrames;
+    voice.fetchPosition = voice.position;
+    return numFrames;
+}
+
+int VoicePool::renderVarispeed(Voice& voice, int numSamples)
+{
+    auto startStep = voice.speed.getCurrentValue();
+    auto remaining = (double) (voice.end - voice.position) - voice.fraction;
+    auto numFrames = (int) juce::jlimit(1.0, (double) numSamples, std::ceil(remaining / startStep));
+    auto endStep = voice.speed.skip(numFrames);
+    auto startGain = voice.gain.getCurrentValue();
+    auto endGain = voice.gain.skip(numFrames);
+    
+    // the window holds the history followed by the frames fetched for this block, positions are relative to it
+    auto windowStart = voice.fetchPosition - historyLength;
+    auto readStart = (double) (voice.position - windowStart) + voice.fraction;
+    auto readEnd = interpolator.setPositions(readStart, startStep, endStep, numFrames);
+    auto numNew = juce::jmax(0, (int) readEnd + VarispeedInterpolator::lookAhead + 1 - historyLength);
+    
+    jassert (historyLength + numNew <= window.getNumSamples());
+    
+    for (int ch = 0; ch < window.getNumChannels(); ++ch)
+        window.copyFrom(ch, 0, voice.history.data() + ch * historyLength, historyLength);
+    
+    // the gain goes onto the source frames as they are fetched, so the history already carries it
+    fetch(voice, historyLength, numNew, startGain, endGain);
+    
+    for (int ch = 0; ch < window.getNumChannels(); ++ch)
+    {
+        interpolator.process(interpolation, window.getReadPointer(ch), scratch.getWritePointer(ch));
+        juce::FloatVectorOperations::copy(voice.history.data() + ch * historyLength, window.getReadPointer(ch, numNew), historyLength);
+    }
+    
+    auto next = (double) windowStart + readEnd;
+    voice.position = (juce::int64) std::floor(next);
+    voice.fraction = next - (double) voice.position;
+    voice.fetchPosition += numNew;
+    return numFrames;
+}
+
+#pragma mark -
+
+const VoicePool::Voice* VoicePool::find(VoiceId id) const
+{
+    if (!juce::isPositiveAndBelow(id.index, numSlots))
+        return nullptr;
+    
+    auto& voice = voices[(size_t) id.index];
+    return voice.sample != nullptr && voice.generation == id.generation ? &voice : nullptr;
+}
+
+VoicePool::Voice* VoicePool::find(VoiceId id)
+{
+    return const_cast<Voice*>(std::as_const(*this).find(id));
+}
+
+// switching over mid-sample, the frames behind the position are read back from the resident part; the ones
+// from the streamed tail can't be read again and are already in the history, kept there by renderDirect
+void VoicePool::beginVarispeed(Voice& voice)
+{
+    auto* sample = voice.sample;
+    auto historyStart = voice.position - historyLength;
+    auto first = juce::jmax((juce::int64) 0, historyStart);
+    auto numAvailable = (int) juce::jmax((juce::int64) 0, juce::jmin(voice.position, sample->getResidentLength()) - first);
+    
+    auto gain = voice.gain.getCurrentValue();
+    
+    if (numAvailable > 0)
+        for (int ch = 0; ch < window.getNumChannels(); ++ch)
+            sample->read(ch % sample->getNumChannels(), first, voice.history.data() + ch * historyLength + (first - historyStart), numAvailable, gain, gain);
+    
+    voice.fetchPosition = voice.position;
+    voice.isVarispeed = true;
+}
+
+void VoicePool::keepStreamedHistory(Voice& voice, int start, int numFrames)
+{
+    auto numKept = juce::jmin(numFrames, historyLength);
+    
+    for (int ch = 0; ch < scratch.getNumChannels(); ++ch)
+    {
+        auto* history = voice.history.data() + ch * historyLength;
+        
+        std::copy(history + numKept, history + historyLength, history);
+        juce::FloatVectorOperations::copy(history + historyLength - numKept, scratch.getReadPointer(ch, start + numFrames - numKept), numKept);
+    }
+}
+
+void VoicePool::fetch(Voice& voice, int destStart, int numFrames, float startGain, float endGain)
+{
+    auto* sample = voice.sample;
+    auto position = voice.fetchPosition;
+    auto numResident = (int) juce::jlimit((juce::int64) 0, (juce::int64) numFrames, sample->getResidentLength() - position);
+    auto numAvailable = (int) juce::jlimit((juce::int64) 0, (juce::int64) numFrames, sample->getNumSamples() - position);
+    
+    auto gainAt = [=] (int frame) { return numFrames > 0 ? startGain + (endGain - startGain) * (float) frame / (float) numFrames : startGain; };
+    
+    if (numResident > 0)
+        for (int ch = 0; ch < window.getNumChannels(); ++ch)
+            sample->read(ch % sample->getNumChannels(), position, window.getWritePointer(ch, destStart), numResident, startGain, gainAt(numResident));
+    
+    auto numStreamed = numAvailable - numResident;
+    auto numRead = numStreamed > 0 && voice.stream != -1 ? streamer.read(voice.stream, window, destStart + numResident, numStreamed, gainAt(numResident), gainAt(numAvailable)) : 0;
+    
+    // past the end of the sample the kernels read silence
+    if (numResident + numRead < numFrames)
+        window.clear(destStart + numResident + numRead, numFrames - numResident - numRead);
+}
+
+void VoicePool::applyFades(const Voice& voice, int numFrames)
+{
+    auto isFadingIn = voice.fadeInElapsed < voice.fadeInLength;
+    auto isFadingOut = voice.fadeOutRemaining >= 0;
+    
+    if (!isFadingIn && !isFadingOut)
+        return;
+    
+    juce::FloatVectorOperations::fill(envelope, 1.0f, numFrames);
+    
+    // both fades count output frames, so an incoming and an outgoing voice started together stay in step
+    if (isFadingIn)
+    {
+        auto numFading = (int) juce::jmin((juce::int64) numFrames, voice.fadeInLength - voice.fadeInElapsed);
+        
+        for (int i = 0; i < numFading; ++i)
+            envelope[i] = lookupFade((double) (voice.fadeInElapsed + i) / (double) voice.fadeInLength);
+    }
+    
+    if (isFadingOut)
+        for (int i = 0; i < numFrames; ++i)
+            envelope[i] *= lookupFade((double) (voice.fadeOutRemaining - i) / (double) voice.fadeOutLength);
+    
+    for (int ch = 0; ch < scratch.getNumChannels(); ++ch)
+        juce::FloatVectorOperations::multiply(scratch.getWritePointer(ch), envelope, numFrames);
+}
+
+int VoicePool::findVictim(bool withStream) const
+{
+    auto victim = -1;
+    
+    for (int i = 0; i < numActive; ++i)
+    {
+        auto& voice = voices[(size_t) activeVoices[(size_t) i]];
+        if (!voice.stealable || voice.isStolen || (withStream && voice.stream == -1))
+            continue;
+        
+        if (victim == -1)
+        {
+            victim = i;
+            continue;
+        }
+        
+        auto& current = voices[(size_t) activeVoices[(size_t) victim]];
+        
+        switch (stealing)
+        {
+            case Stealing::oldest:
+                if (voice.startOrder < current.startOrder)
+                    victim = i;
+                break;
+            
+            case Stealing::quietest:
+                if (voice.level < current.level)
+                    victim = i;
+                break;
+        }
+    }
+    
+    return victim;
+}
+
+int VoicePool::findShortestStolen() const
+{
+    auto shortest = -1;
+    
+    for (int i = 0; i < numActive; ++i)
+    {
+        auto& voice = voices[(size_t) activeVoices[(size_t) i]];
+        
+        if (voice.isStolen && (shortest == -1 || voice.fadeOutRemaining < voices[(size_t) activeVoices[(size_t) shortest]].fadeOutRemaining))
+            shortest = i;
+    }
+    
+    return shortest;
+}
+
+void VoicePool::steal(Voice& voice, VoiceId heir)
+{
+    // its id stops finding it straight away, the voice only lives on for its fade
+    ++voice.generation;
+    voice.isStolen = true;
+    voice.streamHeir = heir;
+    ++numStolen;
+    
+    beginFadeOut(voice, shortFadeLength);
+}
+
+juce::int64 VoicePool::getRemaining(const Voice& voice) const
+{
+    auto frames = (juce::int64) std::ceil(((double) (voice.end - voice.position) - voice.fraction) / voice.speed.getCurrentValue());
+    return voice.fadeOutRemaining >= 0 ? juce::jmin(frames, voice.fadeOutRemaining) : frames;
+}
+
+void VoicePool::beginFadeOut(Voice& voice, juce::int64 length)
+{
+    auto frames = juce::jlimit((juce::int64) 1, juce::jmax((juce::int64) 1, getRemaining(voice)), length);
+    
+    // a voice already fading only ever gets shorter, rescaled so its level carries on from where it is
+    if (voice.fadeOutRemaining >= 0)
+    {
+        if (frames < voice.fadeOutRemaining)
+        {
+            voice.fadeOutLength = juce::jmax((juce::int64) 1, frames * voice.fadeOutLength / voice.fadeOutRemaining);
+            voice.fadeOutRemaining = frames;
+        }
+        
+        return;
+    }
+    
+    voice.fadeOutLength = frames;
+    voice.fadeOutRemaining = frames;
+}
+
+void VoicePool::release(int activeIndex)
+{
+    auto& voice = voices[(size_t) activeVoices[(size_t) activeIndex]];
+    
+    auto* heir = voice.isStolen ? find(voice.streamHeir) : nullptr;
+    
+    if (voice.stream != -1 && heir != nullptr && heir->stream == -1)
+    {
+        heir->stream = voice.stream;
+        streamer.start(heir->stream, heir->sample, juce::jmax(heir->fetchPosition, heir->sample->getResidentLength()));
+        voice.stream = -1;
+    }
+    
+    if (voice.stream != -1)
+    {
+        streamer.stop(voice.stream);
+        streamsInUse[(size_t) voice.stream] = false;
+        voice.stream = -1;
+    }
+    
+    if (voice.isStolen)
+    {
+        voice.isStolen = false;
+        --numStolen;
+    }
+    
+    voice.sample = nullptr;
+    voice.gainSource = nullptr;
+    activeVoices[(size_t) activeIndex] = activeVoices[(size_t) --numActive];
+}
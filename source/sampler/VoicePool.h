@@ -0,0 +1,138 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "models/Sample.h"
+#include "sampler/SampleStreamer.h"
+#include "sampler/VarispeedInterpolator.h"
+
+
+// Fixed set of preallocated voices, each playing a range of one sample, mixed into the output.
+// Apart from prepare() everything runs on the audio thread and never allocates. Only active
+// voices are visited, so rendering cost grows with the number of sounding voices. Positions
+// count source frames, fade lengths count output frames, so fades last as long at any speed.
+class VoicePool final
+{
+public:
+    static constexpr int maxVoices = 32;
+    static constexpr int maxStreams = 4;
+    static constexpr int maxChannels = 8;
+    static constexpr float maxSpeed = 4.0f;
+    
+    enum class Stealing { oldest, quietest };
+    static constexpr char const *stealingLabels[] = { "Oldest", "Quietest", nullptr };
+    
+    // identifies one start of a voice, so a stolen or finished voice is never mistaken for its successor
+    struct VoiceId
+    {
+        int index = -1;
+        juce::uint32 generation = 0;
+    };
+    
+    explicit VoicePool(SampleStreamer& streamer);
+    
+    void prepare(double sampleRate, int numChannels, int maximumBlockSize);
+    void setStealing(Stealing policy);
+    
+    // playback speed of every voice, each glides to it over a short ramp; at exactly 1 voices copy frames
+    // directly, otherwise they read at fractional positions through the interpolator
+    void setSpeed(float speed);
+    void setInterpolation(VarispeedInterpolator::Type type);
+    
+    // steals a voice when all are busy, unstealable voices are never taken. A streamed voice that finds
+    // every stream busy takes the stream of a voice picked the same way, which ends; if there is none it
+    // plays only the resident head and fades out at its end. Stolen voices are gone for their callers
+    // at once but fade out briefly in a reserve of their own, a stolen stream moves on once that is done
+    VoiceId start(const Sample* sample, const std::atomic<float>* gain, juce::int64 startPosition, juce::int64 end, bool stealable = true, juce::int64 fadeInLength = 0);
+    void stop(VoiceId id);
+    void setStealable(VoiceId id, bool stealable);
+    
+    // equal-power fade to silence over the next length output frames, after which the voice ends
+    void fadeOut(VoiceId id, juce::int64 length);
+    
+    // the same for every voice that would otherwise sound for longer
+    void fadeOutAll(juce::int64 length);
+    void stopAll();
+    
+    bool isActive(VoiceId id) const;
+    juce::int64 getPosition(VoiceId id) const;
+    
+    // output frames left at the voice's current speed
+    juce::int64 getRemaining(VoiceId id) const;
+    int getNumActive() const;
+    
+    // adds every active voice into the output and releases the ones that reach their end
+    void render(juce::AudioBuffer<float>& output, int startSample, int numSamples);
+    
+private:
+    static constexpr int historyLength = 16;
+    static constexpr int maxStolen = 8;
+    static constexpr int numSlots = maxVoices + maxStolen;
+    
+    struct Voice
+    {
+        const Sample* sample = nullptr;
+        const std::atomic<float>* gainSource = nullptr;
+        juce::SmoothedValue<float> gain;
+        juce::SmoothedValue<float> speed;
+        juce::int64 position = 0;
+        double fraction = 0.0;
+        juce::int64 end = 0;
+        juce::int64 fadeInLength = 0;
+        juce::int64 fadeInElapsed = 0;
+        juce::int64 fadeOutLength = 0;
+        juce::int64 fadeOutRemaining = -1;  // -1 until a fade-out starts
+        juce::uint32 generation = 0;
+        juce::uint64 startOrder = 0;
+        float level = 0.0f;
+        int stream = -1;
+        bool stealable = true;
+        
+        // set while a stolen voice fades out, its stream then goes on to the voice that took it
+        bool isStolen = false;
+        VoiceId streamHeir;
+        
+        // once off the direct path a voice keeps the last source frames it read, the interpolator
+        // reaches back into them, and reads ahead of position up to fetchPosition. On the direct path
+        // it keeps the last frames read from its stream, so a switch in the tail has them to start from
+        bool isVarispeed = false;
+        juce::int64 fetchPosition = 0;
+        std::array<float, (size_t) (historyLength * maxChannels)> history {};
+    };
+    
+    SampleStreamer& streamer;
+    std::array<Voice, numSlots> voices;
+    std::array<int, numSlots> activeVoices {};
+    std::array<bool, maxStreams> streamsInUse {};
+    int numActive = 0;
+    int numStolen = 0;
+    juce::uint64 numStarted = 0;
+    Stealing stealing = Stealing::oldest;
+    float targetSpeed = 1.0f;
+    VarispeedInterpolator::Type interpolation = VarispeedInterpolator::Type::cubic;
+    VarispeedInterpolator interpolator;
+    juce::AudioSampleBuffer scratch;
+    juce::AudioSampleBuffer window;
+    juce::HeapBlock<float> envelope;
+    
+    // for voices that have to end early: stolen ones and streamed ones cut at their head
+    juce::int64 shortFadeLength = 1;
+    
+    const Voice* find(VoiceId id) const;
+    Voice* find(VoiceId id);
+    int findVictim(bool withStream) const;
+    int findShortestStolen() const;
+    void steal(Voice& voice, VoiceId heir);
+    bool startStream(int index);
+    juce::int64 getRemaining(const Voice& voice) const;
+    void beginFadeOut(Voice& voice, juce::int64 length);
+    void release(int activeIndex);
+    void renderVoice(Voice& voice, juce::AudioBuffer<float>& output, int startSample, int numSamples);
+    int renderDirect(Voice& voice, int numSamples);
+    int renderVarispeed(Voice& voice, int numSamples);
+    void beginVarispeed(Voice& voice);
+    void keepStreamedHistory(Voice& voice, int start, int numFrames);
+    void fetch(Voice& voice, int destStart, int numFrames, float startGain, float endGain);
+    void applyFades(const Voice& voice, int numFrames);
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoicePool)
+};
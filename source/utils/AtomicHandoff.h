@@ -0,0 +1,80 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+
+// Hands immutable objects built on the message thread over to the audio thread.
+// The audio thread never allocates or deletes: a replaced object is parked in
+// `retired` and freed on the message thread by the next collect() or publish().
+template <typename T>
+class AtomicHandoff final
+{
+public:
+    AtomicHandoff() = default;
+    
+    ~AtomicHandoff()
+    {
+        delete pending.exchange(nullptr);
+        delete retired.exchange(nullptr);
+        delete previous;
+        delete current;
+    }
+    
+    // message thread
+    void publish(std::unique_ptr<T> next)
+    {
+        collect();
+        delete pending.exchange(next.release(), std::memory_order_acq_rel);
+    }
+    
+    void collect()
+    {
+        delete retired.exchange(nullptr, std::memory_order_acquire);
+    }
+    
+    bool hasPending() const
+    {
+        return pending.load(std::memory_order_acquire) != nullptr;
+    }
+    
+    // audio thread (or any thread holding the processor callback lock). With keepsPrevious the
+    // replaced object stays alive until releasePrevious(), nothing new is taken over meanwhile
+    T* acquire(bool keepsPrevious = false)
+    {
+        if (previous == nullptr && retired.load(std::memory_order_acquire) == nullptr)
+        {
+            if (auto* next = pending.exchange(nullptr, std::memory_order_acq_rel))
+            {
+                if (keepsPrevious)
+                    previous = current;
+                else
+                    retired.store(current, std::memory_order_release);
+                
+                current = next;
+            }
+        }
+        
+        return current;
+    }
+    
+    void releasePrevious()
+    {
+        if (previous == nullptr)
+            return;
+        
+        // only ever taken over while nothing was retired, and only this thread retires
+        jassert (retired.load(std::memory_order_acquire) == nullptr);
+        retired.store(std::exchange(previous, nullptr), std::memory_order_release);
+    }
+    
+private:
+    std::atomic<T*> pending { nullptr };
+    std::atomic<T*> retired { nullptr };
+    T* current = nullptr;
+    T* previous = nullptr;
+    
+    JUCE_DECLARE_NON_COPYABLE (AtomicHandoff)
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+
+
+// Carries small trivially copyable events from one producer thread to one consumer thread.
+// Both sides are wait-free: a push onto a full queue drops the event rather than waiting,
+// so the audio thread can report what happened without ever blocking on the UI.
+template <typename Event, int capacity>
+class EventFifo final
+{
+public:
+    static_assert (std::is_trivially_copyable_v<Event>);
+    
+    EventFifo() = default;
+    
+    // producer
+    bool push(const Event& event)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(1, start1, size1, start2, size2);
+        
+        if (size1 == 0)
+            return false;
+        
+        events[(size_t) start1] = event;
+        fifo.finishedWrite(1);
+        return true;
+    }
+    
+    // consumer: hands over everything queued so far, oldest first
+    template <typename Callback>
+    int drain(Callback&& callback)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+        
+        for (int i = 0; i < size1; ++i)
+            callback(events[(size_t) (start1 + i)]);
+        
+        for (int i = 0; i < size2; ++i)
+            callback(events[(size_t) (start2 + i)]);
+        
+        fifo.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+    
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<Event, (size_t) capacity> events {};
+    
+    JUCE_DECLARE_NON_COPYABLE (EventFifo)
+};
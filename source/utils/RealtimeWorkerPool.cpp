@@ -0,0 +1,191 @@
+#include "RealtimeWorkerPool.h"
+#include <bit>
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+
+namespace
+{
+    // tells the core we're spinning, so it can give the other hyperthread the pipeline
+    inline void relax()
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && (JUCE_CLANG || JUCE_GCC)
+        __asm__ __volatile__ ("yield");
+       #endif
+    }
+}
+
+#pragma mark -
+
+class RealtimeWorkerPool::Worker final : public juce::Thread
+{
+public:
+    explicit Worker(RealtimeWorkerPool& p) : juce::Thread("Realtime worker"), pool(p) {}
+    
+    void run() override
+    {
+        juce::ScopedNoDenormals noDenormals;
+        juce::WorkgroupToken token;
+        int joinedGeneration = 0;
+        auto seen = pool.batch.load(std::memory_order_acquire);
+        
+        while (!threadShouldExit())
+        {
+            if (auto generation = pool.workgroupGeneration.load(std::memory_order_acquire); generation != joinedGeneration)
+            {
+                joinWorkgroup(token);
+                joinedGeneration = generation;
+            }
+            
+            auto spinUntil = juce::Time::getHighResolutionTicks() + juce::Time::secondsToHighResolutionTicks(spinSeconds);
+            while (pool.batch.load(std::memory_order_acquire) == seen && juce::Time::getHighResolutionTicks() < spinUntil)
+                relax();
+            
+            // the caller only notifies when it sees a sleeper, and a batch stored before this count
+            // went up makes the wait return straight away
+            if (pool.batch.load(std::memory_order_acquire) == seen)
+            {
+                pool.numSleeping.fetch_add(1, std::memory_order_seq_cst);
+                pool.batch.wait(seen, std::memory_order_seq_cst);
+                pool.numSleeping.fetch_sub(1, std::memory_order_seq_cst);
+            }
+            
+            seen = pool.batch.load(std::memory_order_acquire);
+            while (pool.runNextJob(seen)) {}
+        }
+    }
+    
+private:
+    RealtimeWorkerPool& pool;
+    
+    void joinWorkgroup(juce::WorkgroupToken& token)
+    {
+        juce::AudioWorkgroup workgroup;
+        {
+            const juce::SpinLock::ScopedLockType lock(pool.workgroupLock);
+            workgroup = pool.workgroup;
+        }
+        
+        token.reset();
+        if (workgroup)
+            workgroup.join(token);
+    }
+};
+
+#pragma mark -
+
+RealtimeWorkerPool::RealtimeWorkerPool(int numWorkers, Job j) : job(std::move(j))
+{
+    for (int i = 0; i < numWorkers; ++i)
+        workers.add(new Worker(*this));
+}
+
+RealtimeWorkerPool::~RealtimeWorkerPool()
+{
+    stopWorkers();
+}
+
+#pragma mark -
+
+void RealtimeWorkerPool::prepare(double sampleRate, int blockSize)
+{
+    stopWorkers();
+    
+    auto options = juce::Thread::RealtimeOptions{}.withApproximateAudioProcessingTime(blockSize, sampleRate);
+    
+    for (auto* worker : workers)
+        if (!worker->startRealtimeThread(options))
+            worker->startThread(juce::Thread::Priority::highest);
+}
+
+void RealtimeWorkerPool::setWorkgroup(const juce::AudioWorkgroup& newWorkgroup)
+{
+    {
+        const juce::SpinLock::ScopedLockType lock(workgroupLock);
+        workgroup = newWorkgroup;
+    }
+    
+    workgroupGeneration.fetch_add(1, std::memory_order_release);
+    wakeWorkers();
+}
+
+void RealtimeWorkerPool::stopWorkers()
+{
+    for (auto* worker : workers)
+        worker->signalThreadShouldExit();
+    
+    wakeWorkers();
+    
+    for (auto* worker : workers)
+        worker->stopThread(1000);
+}
+
+void RealtimeWorkerPool::wakeWorkers()
+{
+    // a batch id nobody has claimed from, so workers wake, find nothing and look at their flags
+    batch.fetch_add(1, std::memory_order_seq_cst);
+    batch.notify_all();
+}
+
+#pragma mark -
+
+void RealtimeWorkerPool::run(juce::uint32 jobs)
+{
+    if (jobs == 0)
+        return;
+    
+    if (workers.isEmpty() || std::has_single_bit(jobs))
+    {
+        runJobs(jobs);
+        return;
+    }
+    
+    // the claim store below publishes these to whichever worker takes a job
+    busy.store(jobs, std::memory_order_relaxed);
+    
+    auto batchId = batch.load(std::memory_order_relaxed) + 1;
+    claim.store(((juce::uint64) batchId << 32) | jobs, std::memory_order_release);
+    batch.store(batchId, std::memory_order_seq_cst);
+    
+    // the caller takes one job itself, workers still spinning take theirs without a wake-up
+    auto numToWake = juce::jmin(std::popcount(jobs) - 1, numSleeping.load(std::memory_order_seq_cst));
+    for (int i = 0; i < numToWake; ++i)
+        batch.notify_one();
+    
+    while (runNextJob(batchId)) {}
+    
+    // every job is claimed by now, the last ones may still be running on workers
+    while (busy.load(std::memory_order_acquire) != 0)
+        relax();
+}
+
+void RealtimeWorkerPool::runJobs(juce::uint32 jobs)
+{
+    for (; jobs != 0; jobs &= jobs - 1)
+        job(std::countr_zero(jobs));
+}
+
+bool RealtimeWorkerPool::runNextJob(juce::uint32 batchId)
+{
+    auto current = claim.load(std::memory_order_acquire);
+    
+    for (;;)
+    {
+        auto unclaimed = (juce::uint32) current;
+        if ((juce::uint32) (current >> 32) != batchId || unclaimed == 0)
+            return false;
+        
+        auto index = std::countr_zero(unclaimed);
+        
+        if (claim.compare_exchange_weak(current, current & ~((juce::uint64) 1 << index), std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            job(index);
+            busy.fetch_and(~((juce::uint32) 1 << index), std::memory_order_release);
+            return true;
+        }
+    }
+}
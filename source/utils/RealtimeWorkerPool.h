@@ -0,0 +1,61 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <atomic>
+
+
+// Splits a batch of independent jobs across a fixed set of realtime threads, with the thread that
+// asks for the batch taking jobs as well. Nothing is allocated once the pool is built and a batch
+// never takes a lock: every thread claims the next unclaimed job from one shared mask, so whichever
+// thread is free steals the next job. Workers spin for a few microseconds after a batch, in case the
+// caller has more, then sleep on an atomic wait; a batch wakes only as many of them as it has jobs
+// beyond the one the caller takes, so idle workers never hold a core. The caller never waits for a job nobody has started, it runs those itself,
+// and then waits for the ones workers are running, so every batch finishes within the call.
+class RealtimeWorkerPool final
+{
+public:
+    static constexpr int maxJobs = 32;
+    
+    using Job = juce::FixedSizeFunction<64, void(int)>;
+    
+    RealtimeWorkerPool(int numWorkers, Job job);
+    ~RealtimeWorkerPool();
+    
+    int getNumWorkers() const { return workers.size(); }
+    
+    // message thread, while the audio thread isn't running: (re)starts the workers as realtime
+    // threads for blocks of this size
+    void prepare(double sampleRate, int blockSize);
+    
+    // any thread: workers join the host's audio workgroup the next time they wake
+    void setWorkgroup(const juce::AudioWorkgroup& workgroup);
+    
+    // audio thread: runs the job for every set bit of jobs and returns once all of them have finished
+    void run(juce::uint32 jobs);
+    
+private:
+    class Worker;
+    
+    static constexpr double spinSeconds = 0.00005;
+    
+    juce::OwnedArray<Worker> workers;
+    Job job;
+    
+    // the batch id sits in the upper half so a worker waking late can't claim a job of a newer batch,
+    // the lower half holds the jobs nobody has claimed yet
+    std::atomic<juce::uint64> claim { 0 };
+    std::atomic<juce::uint32> batch { 0 };
+    std::atomic<juce::uint32> busy { 0 };
+    std::atomic<int> numSleeping { 0 };
+    
+    juce::SpinLock workgroupLock;
+    juce::AudioWorkgroup workgroup;
+    std::atomic<int> workgroupGeneration { 0 };
+    
+    void stopWorkers();
+    void wakeWorkers();
+    void runJobs(juce::uint32 jobs);
+    bool runNextJob(juce::uint32 batchId);
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RealtimeWorkerPool)
+};
@@ -0,0 +1,101 @@
+#include <ProcessorBase.h>
+#include <processors/CrossfadingChain.h>
+#include <catch2/catch_test_macros.hpp>
+
+// adds a constant to every sample and counts how often it has run
+class OffsetProcessor final : public ProcessorBase
+{
+public:
+    OffsetProcessor (float o, int& c) : offset (o), calls (c) {}
+
+    void processBlock (juce::AudioBuffer<float>& audioBuffer, juce::MidiBuffer&) override
+    {
+        ++calls;
+        for (int ch = 0; ch < audioBuffer.getNumChannels(); ++ch)
+            juce::FloatVectorOperations::add (audioBuffer.getWritePointer (ch), offset, audioBuffer.getNumSamples());
+    }
+
+private:
+    float offset;
+    int& calls;
+};
+
+TEST_CASE ("Crossfading chain", "[chain]")
+{
+    auto gui = juce::ScopedJuceInitialiser_GUI {};
+
+    // at this rate a fade lasts two blocks
+    const int blockSize = 10;
+    CrossfadingChain chain;
+    chain.prepare (1, 1000.0, blockSize);
+
+    juce::AudioBuffer<float> buffer (1, blockSize);
+    juce::MidiBuffer midi;
+    int callsA = 0, callsB = 0;
+
+    auto render = [&] {
+        buffer.clear();
+        chain.process (buffer, midi);
+        return std::pair { buffer.getSample (0, 0), buffer.getSample (0, blockSize - 1) };
+    };
+
+    SECTION ("fades a new effect in over the dry signal")
+    {
+        REQUIRE (chain.add (std::make_unique<OffsetProcessor> (1.0f, callsA)));
+
+        auto [first, last] = render();
+        CHECK (first > 0.0f);
+        CHECK (first < last);
+        CHECK (last < 1.0f);
+
+        render();
+        CHECK (render() == std::pair { 1.0f, 1.0f });
+    }
+
+    SECTION ("fades a removed effect out before dropping it")
+    {
+        auto effect = std::make_unique<OffsetProcessor> (1.0f, callsA);
+        auto* raw = effect.get();
+        chain.add (std::move (effect));
+        render();
+        render();
+
+        chain.remove (raw);
+        CHECK (chain.size() == 0);
+
+        auto [first, last] = render();
+        CHECK (first < 1.0f);
+        CHECK (last < first);
+        CHECK (last > 0.0f);
+
+        render();
+        auto callsWhileFading = callsA;
+        CHECK (render() == std::pair { 0.0f, 0.0f });
+        CHECK (callsA == callsWhileFading);
+    }
+
+    SECTION ("leaves effects that stay at full level")
+    {
+        chain.add (std::make_unique<OffsetProcessor> (1.0f, callsA));
+        render();
+        render();
+
+        chain.add (std::make_unique<OffsetProcessor> (1.0f, callsB));
+        auto [first, last] = render();
+        CHECK (first > 1.0f);
+        CHECK (last < 2.0f);
+
+        render();
+        CHECK (render() == std::pair { 2.0f, 2.0f });
+        CHECK (callsA == 5);
+    }
+
+    SECTION ("refuses effects beyond its capacity")
+    {
+        for (int i = 0; i < CrossfadingChain::maxEffects; ++i)
+            REQUIRE (chain.add (std::make_unique<OffsetProcessor> (0.0f, callsA)));
+
+        CHECK_FALSE (chain.add (std::make_unique<OffsetProcessor> (0.0f, callsB)));
+        CHECK (chain.size() == CrossfadingChain::maxEffects);
+    }
+}
@@ -0,0 +1,75 @@
+#include <utils/EventFifo.h>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+#include <vector>
+
+TEST_CASE ("Event FIFO", "[events]")
+{
+    // one slot of the underlying AbstractFifo always stays empty
+    EventFifo<int, 8> fifo;
+    const int numFree = 7;
+
+    std::vector<int> received;
+    auto receive = [&received] (int event) { received.push_back (event); };
+
+    SECTION ("hands events over oldest first")
+    {
+        fifo.push (1);
+        fifo.push (2);
+        fifo.push (3);
+
+        CHECK (fifo.drain (receive) == 3);
+        CHECK (received == std::vector<int> { 1, 2, 3 });
+        CHECK (fifo.drain (receive) == 0);
+    }
+
+    SECTION ("drops events once full and keeps the ones already queued")
+    {
+        for (int i = 0; i < numFree; ++i)
+            CHECK (fifo.push (i));
+
+        CHECK_FALSE (fifo.push (100));
+        CHECK (fifo.drain (receive) == numFree);
+        CHECK (received == std::vector<int> { 0, 1, 2, 3, 4, 5, 6 });
+
+        CHECK (fifo.push (100));
+    }
+
+    SECTION ("keeps the order across the end of the buffer")
+    {
+        for (int i = 0; i < 5; ++i)
+            fifo.push (i);
+
+        fifo.drain ([] (int) {});
+
+        // these run past the last slot and carry on from the first
+        for (int i = 0; i < numFree; ++i)
+            CHECK (fifo.push (10 + i));
+
+        CHECK (fifo.drain (receive) == numFree);
+        CHECK (received == std::vector<int> { 10, 11, 12, 13, 14, 15, 16 });
+    }
+
+    SECTION ("passes events from one thread to another in order")
+    {
+        const int numEvents = 100000;
+
+        std::thread producer ([&fifo] {
+            for (int i = 0; i < numEvents; ++i)
+                while (!fifo.push (i))
+                    std::this_thread::yield();
+        });
+
+        while ((int) received.size() < numEvents)
+            if (fifo.drain (receive) == 0)
+                std::this_thread::yield();
+
+        producer.join();
+
+        bool isInOrder = true;
+        for (int i = 0; i < numEvents; ++i)
+            isInOrder = isInOrder && received[(size_t) i] == i;
+
+        CHECK (isInOrder);
+    }
+}
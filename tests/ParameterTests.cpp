@@ -0,0 +1,130 @@
+#include <ProcessorBase.h>
+#include <parameters/ParameterRegistry.h>
+#include <parameters/ParameterSnapshot.h>
+#include <sampler/SamplerUtils.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+TEST_CASE ("Parameter snapshot", "[parameters]")
+{
+    std::atomic<float> level { 1.0f }, loop { 0.0f };
+
+    ParameterSnapshot snapshot;
+    auto levelHandle = snapshot.add (&level, 0.01);
+    auto loopHandle = snapshot.add (&loop);
+    snapshot.prepare (1000.0);
+
+    SECTION ("changes unsmoothed values at the next block")
+    {
+        loop = 1.0f;
+        CHECK_FALSE (snapshot.isOn (loopHandle));
+
+        snapshot.update (4);
+        CHECK (snapshot.isOn (loopHandle));
+        CHECK (snapshot.getRamp (loopHandle).isConstant());
+    }
+
+    SECTION ("ramps smoothed values across blocks")
+    {
+        level = 0.0f;
+
+        snapshot.update (5);
+        CHECK_THAT (snapshot.getRamp (levelHandle).start, Catch::Matchers::WithinAbs (1.0, 1.0e-6));
+        CHECK_THAT (snapshot.getRamp (levelHandle).end, Catch::Matchers::WithinAbs (0.5, 1.0e-6));
+
+        snapshot.update (10);
+        CHECK_THAT (snapshot.getRamp (levelHandle).start, Catch::Matchers::WithinAbs (0.5, 1.0e-6));
+        CHECK (snapshot.get (levelHandle) == 0.0f);
+
+        snapshot.update (10);
+        CHECK (snapshot.getRamp (levelHandle).isConstant());
+    }
+
+    SECTION ("applies a ramp to every channel")
+    {
+        level = 0.0f;
+        snapshot.update (10);
+
+        juce::AudioSampleBuffer buffer (2, 10);
+        for (int ch = 0; ch < 2; ++ch)
+            juce::FloatVectorOperations::fill (buffer.getWritePointer (ch), 1.0f, 10);
+
+        snapshot.applyGain (levelHandle, buffer, 0, 10);
+
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < 10; ++i)
+                CHECK_THAT (buffer.getSample (ch, i), Catch::Matchers::WithinAbs (1.0f - (float) i / 10.0f, 1.0e-6));
+    }
+}
+
+TEST_CASE ("Parameter registry", "[parameters]")
+{
+    ProcessorBase processor;
+    ParameterRegistry registry (processor);
+
+    auto loop = registry.addBool ("loop", { "loop", 1 }, "Loop", false);
+    auto count = registry.addInt ("count", { "count", 1 }, "Count", 1, 5, 2);
+    auto order = registry.addChoice ("order", { "order", 1 }, "Order", PlaybackOrder::labels, PlaybackOrder::Order::shuffle);
+
+    SECTION ("registers parameters with the processor")
+    {
+        CHECK (processor.getParameters().size() == 3);
+        CHECK (registry.raw ("count") == registry.raw (count));
+    }
+
+    SECTION ("reads typed values")
+    {
+        CHECK_FALSE (registry.get (loop));
+        CHECK (registry.get (count) == 2);
+        CHECK (registry.get (order) == PlaybackOrder::Order::shuffle);
+
+        registry.set (order, PlaybackOrder::Order::random);
+        CHECK (registry.get (order) == PlaybackOrder::Order::random);
+    }
+
+    SECTION ("round trips through xml with choices stored by label")
+    {
+        registry.set (loop, true);
+        registry.set (order, PlaybackOrder::Order::random);
+
+        juce::XmlElement xml ("State");
+        registry.write (loop, xml);
+        registry.write (order, xml);
+        CHECK (xml.getChildByName ("order")->getAllSubText() == "Random");
+
+        registry.set (loop, false);
+        registry.set (order, PlaybackOrder::Order::ordinal);
+        registry.read (loop, xml);
+        registry.read (order, xml);
+
+        CHECK (registry.get (loop));
+        CHECK (registry.get (order) == PlaybackOrder::Order::random);
+    }
+
+    SECTION ("calls back by namespace")
+    {
+        int numCalls = 0;
+        registry.call ("count", [&] { ++numCalls; });
+
+        registry.set (count, 4);
+        registry.set (loop, true);
+        CHECK (numCalls == 1);
+    }
+}
+
+TEST_CASE ("Parameter registry builds a value tree layout", "[parameters]")
+{
+    ProcessorBase processor;
+    ParameterRegistry registry;
+
+    auto level = registry.addFloat ("level", { "level", 1 }, "Level", { 0.0f, 1.0f }, 0.5f);
+    auto order = registry.addChoice ("order", { "order", 1 }, "Order", PlaybackOrder::labels, PlaybackOrder::Order::shuffle);
+    juce::AudioProcessorValueTreeState state (processor, nullptr, "State", registry.takeLayout());
+
+    CHECK (processor.getParameters().size() == 2);
+    CHECK (state.getParameter ("order") == registry.raw (order));
+
+    state.getParameter ("order")->setValueNotifyingHost (1.0f);
+    CHECK (registry.get (order) == PlaybackOrder::Order::random);
+    CHECK (state.getRawParameterValue ("level")->load() == registry.get (level));
+}
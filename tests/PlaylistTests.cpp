@@ -0,0 +1,102 @@
+#include <sampler/PlaylistGenerator.h>
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE ("Playlist generator", "[playlist]")
+{
+    const int numSamples = 8;
+
+    // driven from the test, so every queue fill happens exactly where the test asks for it
+    PlaylistGenerator playlist (false);
+
+    auto pop = [&playlist] {
+        auto entry = playlist.pop();
+        if (entry.index == -1)
+        {
+            playlist.generate();
+            entry = playlist.pop();
+        }
+        return entry;
+    };
+
+    SECTION ("plays in order from the first position and wraps")
+    {
+        playlist.restart (numSamples, PlaybackOrder::Order::ordinal, 5);
+
+        for (int expected : { 5, 6, 7, 0, 1 })
+        {
+            auto entry = pop();
+            CHECK (entry.index == expected);
+            CHECK (entry.position == expected);
+        }
+    }
+
+    SECTION ("shuffles every sample exactly once per pass")
+    {
+        playlist.restart (numSamples, PlaybackOrder::Order::shuffle);
+
+        for (int pass = 0; pass < 3; ++pass)
+        {
+            std::vector<bool> played ((size_t) numSamples);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto entry = pop();
+                REQUIRE (juce::isPositiveAndBelow (entry.index, numSamples));
+                CHECK (entry.position == i);
+                CHECK_FALSE (played[(size_t) entry.index]);
+                played[(size_t) entry.index] = true;
+            }
+        }
+    }
+
+    SECTION ("never picks the same sample twice in a row at random")
+    {
+        playlist.restart (numSamples, PlaybackOrder::Order::random);
+
+        auto previous = pop().index;
+        for (int i = 0; i < 1000; ++i)
+        {
+            auto entry = pop();
+            REQUIRE (juce::isPositiveAndBelow (entry.index, numSamples));
+            CHECK (entry.index != previous);
+            previous = entry.index;
+        }
+    }
+
+    SECTION ("queues nothing until the generator takes up a restart")
+    {
+        playlist.restart (numSamples, PlaybackOrder::Order::ordinal);
+        CHECK (playlist.pop().index == -1);
+
+        playlist.generate();
+        CHECK (playlist.pop().index == 0);
+    }
+
+    SECTION ("drops what was queued before a restart")
+    {
+        playlist.restart (numSamples, PlaybackOrder::Order::ordinal);
+        pop();
+
+        playlist.restart (2, PlaybackOrder::Order::ordinal, 1);
+        CHECK (playlist.pop().index == -1);
+
+        CHECK (pop().index == 1);
+        CHECK (pop().index == 0);
+    }
+
+    SECTION ("drops a stale queue across the wrap of the buffer")
+    {
+        playlist.restart (numSamples, PlaybackOrder::Order::ordinal);
+        playlist.generate();
+
+        for (int i = 0; i < PlaylistGenerator::queueLength / 2 + 3; ++i)
+            playlist.pop();
+
+        playlist.generate();
+        playlist.restart (numSamples, PlaybackOrder::Order::ordinal, 6);
+        playlist.generate();
+
+        for (int expected : { 6, 7, 0 })
+            CHECK (pop().index == expected);
+    }
+}
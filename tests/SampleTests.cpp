@@ -0,0 +1,557 @@
+#include <models/Sample.h>
+#include <models/WaveformPeaks.h>
+#include <sampler/SamplePool.h>
+#include <sampler/SincResampler.h>
+#include <sampler/VoicePool.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+static std::unique_ptr<juce::AudioFormatReader> createReader (const juce::AudioSampleBuffer& buffer, double sampleRate)
+{
+    auto numChannels = buffer.getNumChannels(), numSamples = buffer.getNumSamples();
+    auto block = std::make_unique<juce::MemoryBlock>();
+    {
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (new juce::MemoryOutputStream (*block, false), sampleRate, (unsigned int) numChannels, 32, {}, 0));
+        writer->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+    }
+
+    juce::WavAudioFormat wav;
+    return std::unique_ptr<juce::AudioFormatReader> (wav.createReaderFor (new juce::MemoryInputStream (std::move (*block)), true));
+}
+
+static std::unique_ptr<juce::AudioFormatReader> createRampReader (int numChannels, int numSamples, double sampleRate)
+{
+    juce::AudioSampleBuffer buffer (numChannels, numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < numSamples; ++i)
+            buffer.setSample (ch, i, (float) ((i % 1000) - 500) / 1000.0f * (ch % 2 == 0 ? 1.0f : -1.0f));
+
+    return createReader (buffer, sampleRate);
+}
+
+static std::unique_ptr<juce::AudioFormatReader> createConstantReader (float value, int numSamples, double sampleRate)
+{
+    juce::AudioSampleBuffer buffer (1, numSamples);
+    juce::FloatVectorOperations::fill (buffer.getWritePointer (0), value, numSamples);
+    return createReader (buffer, sampleRate);
+}
+
+TEST_CASE ("Sample chunked storage", "[sample]")
+{
+    const int numSamples = Sample::chunkLength * 2 + 123;
+    auto reader = createRampReader (2, numSamples, 44100.0);
+    REQUIRE (reader != nullptr);
+
+    Sample sample (*reader, 44100.0);
+
+    SECTION ("keeps source length and channels at the same rate")
+    {
+        CHECK (sample.getNumSamples() == numSamples);
+        CHECK (sample.getNumChannels() == 2);
+    }
+
+    SECTION ("reads across chunk boundaries")
+    {
+        const int numToRead = 512;
+        const auto position = (juce::int64) Sample::chunkLength - numToRead / 2;
+
+        std::vector<float> actual ((size_t) numToRead);
+        juce::AudioSampleBuffer source (2, numToRead);
+        reader->read (&source, 0, numToRead, position, true, true);
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            sample.read (ch, position, actual.data(), numToRead);
+            for (int i = 0; i < numToRead; ++i)
+                CHECK (actual[(size_t) i] == source.getSample (ch, i));
+        }
+    }
+
+    SECTION ("applies gain on read without changing the stored data")
+    {
+        const int numToRead = 256;
+        std::vector<float> plain ((size_t) numToRead), silent ((size_t) numToRead), ramped ((size_t) numToRead);
+
+        sample.read (0, 0, plain.data(), numToRead);
+        sample.read (0, 0, silent.data(), numToRead, 0.0f, 0.0f);
+        sample.read (0, 0, ramped.data(), numToRead, 0.0f, 1.0f);
+
+        for (int i = 0; i < numToRead; ++i)
+        {
+            CHECK (silent[(size_t) i] == 0.0f);
+            CHECK_THAT (ramped[(size_t) i], Catch::Matchers::WithinAbs (plain[(size_t) i] * (float) i / (float) numToRead, 1.0e-6));
+        }
+
+        sample.read (0, 0, silent.data(), numToRead);
+        CHECK (silent == plain);
+    }
+}
+
+TEST_CASE ("Sample pool shares samples", "[sample]")
+{
+    SamplePool pool;
+    const SamplePool::Key key { "/kit/kick.wav", 0x1234, 48000.0, Sample::Quality::standard, Sample::Encoding::float32 };
+
+    auto reader = createRampReader (1, 1000, 48000.0);
+    auto added = pool.add (key, { std::make_shared<const Sample> (*reader, 48000.0), std::make_shared<const WaveformPeaks>() });
+
+    SECTION ("finds the same sample for the same key")
+    {
+        auto found = pool.find (key);
+        REQUIRE (found.has_value());
+        CHECK (found->sample == added.sample);
+        CHECK (found->peaks == added.peaks);
+    }
+
+    SECTION ("keeps the first sample added for a key")
+    {
+        auto duplicate = pool.add (key, { std::make_shared<const Sample> (*reader, 48000.0), {} });
+        CHECK (duplicate.sample == added.sample);
+    }
+
+    SECTION ("hands out peaks set after the sample was added")
+    {
+        auto peaks = std::make_shared<const WaveformPeaks>();
+        pool.setPeaks (key, peaks);
+
+        auto found = pool.find (key);
+        REQUIRE (found.has_value());
+        CHECK (found->sample == added.sample);
+        CHECK (found->peaks == peaks);
+    }
+
+    SECTION ("does not match a different target rate")
+    {
+        CHECK_FALSE (pool.find ({ key.path, key.fingerprint, 44100.0, key.quality, key.encoding }).has_value());
+    }
+
+    SECTION ("keeps a sample nobody holds while it fits the budget")
+    {
+        auto* sample = added.sample.get();
+        added.sample.reset();
+
+        auto found = pool.find (key);
+        REQUIRE (found.has_value());
+        CHECK (found->sample.get() == sample);
+        CHECK (pool.getNumBytesKept() == sample->getMemoryUsage());
+    }
+
+    SECTION ("releases samples nobody holds beyond the budget")
+    {
+        added.sample.reset();
+        pool.setBudget (0);
+
+        CHECK_FALSE (pool.find (key).has_value());
+        CHECK (pool.getNumSamples() == 0);
+        CHECK (pool.getNumBytesKept() == 0);
+    }
+
+    SECTION ("lets the least recently used sample go first")
+    {
+        const SamplePool::Key other { "/kit/snare.wav", 0x5678, 48000.0, Sample::Quality::standard, Sample::Encoding::float32 };
+        pool.setBudget (2 * added.sample->getMemoryUsage());
+
+        pool.add (other, { std::make_shared<const Sample> (*reader, 48000.0), {} });
+        added.sample.reset();
+
+        // finding the first one again makes the second the oldest
+        CHECK (pool.find (key).has_value());
+        pool.add ({ "/kit/hat.wav", 0x9abc, 48000.0, Sample::Quality::standard, Sample::Encoding::float32 },
+                  { std::make_shared<const Sample> (*reader, 48000.0), {} });
+
+        CHECK (pool.find (key).has_value());
+        CHECK_FALSE (pool.find (other).has_value());
+        CHECK (pool.getNumSamples() == 2);
+    }
+}
+
+TEST_CASE ("Sinc resampler", "[sample]")
+{
+    const double sourceRate = 44100.0, destRate = 48000.0, frequency = 1000.0;
+
+    juce::AudioSampleBuffer source (2, 44100);
+    for (int i = 0; i < source.getNumSamples(); ++i)
+    {
+        auto value = (float) std::sin (juce::MathConstants<double>::twoPi * frequency * i / sourceRate);
+        source.setSample (0, i, value);
+        source.setSample (1, i, -value);
+    }
+
+    for (auto quality : { SincResampler::Quality::draft, SincResampler::Quality::standard, SincResampler::Quality::mastering })
+    {
+        SincResampler resampler (sourceRate / destRate, quality);
+        REQUIRE (resampler.getNumOutputSamples (source.getNumSamples()) == 48000);
+
+        const int firstFrame = 1000, numFrames = 4096;
+        juce::AudioSampleBuffer output (2, numFrames);
+        resampler.process (source, firstFrame, output.getArrayOfWritePointers(), numFrames);
+
+        auto tolerance = quality == SincResampler::Quality::draft ? 2.0e-2 : 2.0e-3;
+        for (int i = 0; i < numFrames; i += 7)
+        {
+            auto expected = std::sin (juce::MathConstants<double>::twoPi * frequency * (firstFrame + i) / destRate);
+            CHECK_THAT (output.getSample (0, i), Catch::Matchers::WithinAbs (expected, tolerance));
+            CHECK_THAT (output.getSample (1, i), Catch::Matchers::WithinAbs (-expected, tolerance));
+        }
+    }
+}
+
+TEST_CASE ("Sample compact storage", "[sample]")
+{
+    const int numSamples = Sample::chunkLength + 1001;
+    auto reader = createRampReader (2, numSamples, 44100.0);
+    REQUIRE (reader != nullptr);
+
+    juce::AudioSampleBuffer source (2, numSamples);
+    reader->read (&source, 0, numSamples, 0, true, true);
+
+    for (auto [encoding, tolerance] : { std::pair { Sample::Encoding::int16, 1.0e-4f }, std::pair { Sample::Encoding::int24, 1.0e-6f } })
+    {
+        Sample sample (*reader, 44100.0, { Sample::Quality::standard, encoding });
+        REQUIRE (sample.getEncoding() == encoding);
+
+        std::vector<float> actual ((size_t) numSamples);
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            sample.read (ch, 0, actual.data(), numSamples);
+            for (int i = 0; i < numSamples; i += 13)
+                CHECK_THAT (actual[(size_t) i], Catch::Matchers::WithinAbs (source.getSample (ch, i), tolerance));
+        }
+    }
+}
+
+TEST_CASE ("Waveform peak pyramid", "[sample]")
+{
+    const int numSamples = WaveformPeaks::baseDecimation * 100 + 10;
+    juce::AudioSampleBuffer block (2, numSamples);
+    for (int i = 0; i < numSamples; ++i)
+    {
+        block.setSample (0, i, i == 300 ? 0.9f : 0.1f);
+        block.setSample (1, i, i == numSamples - 1 ? -0.8f : -0.1f);
+    }
+
+    WaveformPeaks peaks;
+    peaks.append (block, 0, 1000);
+    peaks.append (block, 1000, numSamples - 1000);
+    peaks.finish();
+
+    SECTION ("base level covers every frame of every channel")
+    {
+        const auto& base = peaks.getLevel (0);
+        REQUIRE (base.size() == 101);
+        CHECK (base[1].getEnd() == 0.9f);
+        CHECK (base[100].getStart() == -0.8f);
+        CHECK (base[50] == juce::Range<float> (-0.1f, 0.1f));
+    }
+
+    SECTION ("upper levels halve down to a single range")
+    {
+        CHECK (peaks.getNumLevels() == 8);
+        CHECK (peaks.getLevel (peaks.getNumLevels() - 1).front() == juce::Range<float> (-0.8f, 0.9f));
+    }
+
+    SECTION ("picks the coarsest level with enough points")
+    {
+        CHECK (peaks.getLevelFor (40).size() == 51);
+        CHECK (peaks.getLevelFor (1000).size() == 101);
+    }
+}
+
+TEST_CASE ("Sample block decoding matches whole-buffer resampling", "[sample]")
+{
+    const int numSamples = Sample::chunkLength * 2 + 777;
+    auto reader = createRampReader (2, numSamples, 44100.0);
+    REQUIRE (reader != nullptr);
+
+    WaveformPeaks peaks;
+    Sample sample (*reader, 48000.0, { Sample::Quality::standard, Sample::Encoding::float32, &peaks, nullptr });
+    peaks.finish();
+
+    juce::AudioSampleBuffer source (2, numSamples);
+    reader->read (&source, 0, numSamples, 0, true, true);
+
+    SincResampler resampler (44100.0 / 48000.0, Sample::Quality::standard);
+    REQUIRE (sample.getNumSamples() == resampler.getNumOutputSamples (numSamples));
+
+    auto expected = juce::AudioSampleBuffer (2, (int) sample.getNumSamples());
+    resampler.process (source, 0, expected.getArrayOfWritePointers(), expected.getNumSamples());
+
+    std::vector<float> actual ((size_t) sample.getNumSamples());
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        sample.read (ch, 0, actual.data(), (int) actual.size());
+        for (size_t i = 0; i < actual.size(); i += 11)
+            CHECK (actual[i] == expected.getSample (ch, (int) i));
+    }
+
+    CHECK (peaks.getLevel (0).size() == (size_t) (numSamples + WaveformPeaks::baseDecimation - 1) / WaveformPeaks::baseDecimation);
+}
+
+TEST_CASE ("Streamed sample heads end as the whole file goes on", "[sample]")
+{
+    const int numSamples = Sample::chunkLength * 2;
+    auto reader = createRampReader (1, numSamples, 44100.0);
+    REQUIRE (reader != nullptr);
+
+    Sample sample (juce::File(), *reader, 48000.0, 0.5);
+    REQUIRE (sample.isStreamed());
+
+    juce::AudioSampleBuffer source (1, numSamples);
+    reader->read (&source, 0, numSamples, 0, true, true);
+
+    SincResampler resampler (44100.0 / 48000.0, Sample::Quality::standard);
+    auto expected = juce::AudioSampleBuffer (1, (int) sample.getResidentLength());
+    resampler.process (source, 0, expected.getArrayOfWritePointers(), expected.getNumSamples());
+
+    // the last frames of the head are where the kernel reaches past the resident part
+    std::vector<float> actual ((size_t) sample.getResidentLength());
+    sample.read (0, 0, actual.data(), (int) actual.size());
+    for (size_t i = actual.size() - 64; i < actual.size(); ++i)
+        CHECK (actual[i] == expected.getSample (0, (int) i));
+}
+
+TEST_CASE ("Sample decoding stops once cancelled", "[sample]")
+{
+    auto reader = createRampReader (1, Sample::chunkLength * 2, 44100.0);
+    REQUIRE (reader != nullptr);
+
+    std::atomic<bool> cancelled { true };
+    CHECK_THROWS (Sample (*reader, 48000.0, { Sample::Quality::standard, Sample::Encoding::float32, nullptr, nullptr, &cancelled }));
+
+    cancelled = false;
+    CHECK_NOTHROW (Sample (*reader, 48000.0, { Sample::Quality::standard, Sample::Encoding::float32, nullptr, nullptr, &cancelled }));
+}
+
+TEST_CASE ("Voice pool", "[sample]")
+{
+    const int numSamples = 4096, blockSize = 256;
+    auto reader = createRampReader (2, numSamples, 44100.0);
+    REQUIRE (reader != nullptr);
+
+    Sample sample (*reader, 44100.0);
+
+    juce::AudioFormatManager formatManager;
+    SampleStreamer streamer (formatManager, VoicePool::maxStreams, 2);
+    VoicePool voices (streamer);
+    voices.prepare (44100.0, 2, blockSize);
+
+    juce::AudioSampleBuffer output (2, blockSize);
+    output.clear();
+
+    SECTION ("mixes overlapping voices")
+    {
+        voices.start (&sample, nullptr, 0, numSamples);
+        voices.start (&sample, nullptr, 0, numSamples);
+        voices.render (output, 0, blockSize);
+
+        std::vector<float> expected ((size_t) blockSize);
+        sample.read (1, 0, expected.data(), blockSize);
+
+        for (int i = 0; i < blockSize; ++i)
+            CHECK_THAT (output.getSample (1, i), Catch::Matchers::WithinAbs (2.0f * expected[(size_t) i], 1.0e-6));
+    }
+
+    SECTION ("releases voices at their end")
+    {
+        auto id = voices.start (&sample, nullptr, numSamples - 100, numSamples);
+        CHECK (voices.getRemaining (id) == 100);
+
+        voices.render (output, 0, blockSize);
+        CHECK_FALSE (voices.isActive (id));
+        CHECK (voices.getNumActive() == 0);
+        CHECK (output.getSample (0, 100) == 0.0f);
+    }
+
+    SECTION ("crossfades at equal power")
+    {
+        auto outgoing = voices.start (&sample, nullptr, 0, numSamples);
+        voices.fadeOut (outgoing, 200);
+        voices.start (&sample, nullptr, 0, numSamples, true, 200);
+        voices.render (output, 0, blockSize);
+
+        std::vector<float> expected ((size_t) blockSize);
+        sample.read (0, 0, expected.data(), blockSize);
+
+        // both voices read the same frames, so the output is the frame times the sum of both gains
+        auto gainOf = [] (double proportion) { return (float) std::sin (juce::MathConstants<double>::halfPi * proportion); };
+        for (int i : { 0, 50, 100, 150, 199 })
+            CHECK_THAT (output.getSample (0, i), Catch::Matchers::WithinAbs (expected[(size_t) i] * (gainOf ((200.0 - i) / 200.0) + gainOf (i / 200.0)), 1.0e-3));
+
+        CHECK_FALSE (voices.isActive (outgoing));
+        CHECK (output.getSample (0, 220) == expected[220]);
+    }
+
+    SECTION ("reads at fractional positions when the speed is not one")
+    {
+        auto type = GENERATE (VarispeedInterpolator::Type::cubic, VarispeedInterpolator::Type::sinc);
+        voices.setInterpolation (type);
+        voices.setSpeed (0.5f);
+
+        auto id = voices.start (&sample, nullptr, 0, numSamples);
+        CHECK (voices.getRemaining (id) == 2 * numSamples);
+
+        voices.render (output, 0, blockSize);
+        CHECK (voices.getPosition (id) == blockSize / 2);
+
+        // both kernels reproduce a straight line exactly once clear of the silence before the start
+        for (int i = 8; i < blockSize; ++i)
+            CHECK_THAT (output.getSample (0, i), Catch::Matchers::WithinAbs ((i * 0.5f - 500.0f) / 1000.0f, 1.0e-4));
+    }
+
+    SECTION ("crossfades at equal power when the speed is not one")
+    {
+        Sample ones (*createConstantReader (1.0f, numSamples, 44100.0), 44100.0);
+        Sample silence (*createConstantReader (0.0f, numSamples, 44100.0), 44100.0);
+
+        // renders each side of the crossfade on its own, so their gains can be read back directly
+        auto crossfade = [&] (const Sample& outgoingSample, const Sample& incomingSample)
+        {
+            VoicePool pool (streamer);
+            pool.prepare (44100.0, 2, blockSize);
+            pool.setSpeed (1.5f);
+
+            juce::AudioSampleBuffer result (2, blockSize);
+            result.clear();
+
+            auto outgoing = pool.start (&outgoingSample, nullptr, 0, numSamples);
+            pool.fadeOut (outgoing, 200);
+            pool.start (&incomingSample, nullptr, 0, numSamples, true, 200);
+            pool.render (result, 0, blockSize);
+
+            CHECK_FALSE (pool.isActive (outgoing));
+            return result;
+        };
+
+        auto fadingOut = crossfade (ones, silence);
+        auto fadingIn = crossfade (silence, ones);
+
+        for (int i = 0; i < 200; ++i)
+        {
+            auto power = fadingOut.getSample (0, i) * fadingOut.getSample (0, i) + fadingIn.getSample (0, i) * fadingIn.getSample (0, i);
+            CHECK_THAT (power, Catch::Matchers::WithinAbs (1.0, 1.0e-3));
+        }
+
+        CHECK (fadingOut.getSample (0, 200) == 0.0f);
+        CHECK_THAT (fadingIn.getSample (0, 200), Catch::Matchers::WithinAbs (1.0, 1.0e-4));
+    }
+
+    SECTION ("ends after the remaining output frames when the speed is not one")
+    {
+        auto speed = GENERATE (0.75f, 1.5f);
+        voices.setSpeed (speed);
+
+        // a gap is counted from the moment the sample before it ends, so that moment has to be exact
+        auto id = voices.start (&sample, nullptr, 0, 1000);
+        auto remaining = voices.getRemaining (id);
+        CHECK (remaining == (juce::int64) std::ceil (1000.0 / speed));
+
+        for (juce::int64 rendered = 0; rendered < remaining - 1;)
+        {
+            auto numThisTime = (int) juce::jmin ((juce::int64) 97, remaining - 1 - rendered);
+            voices.render (output, 0, numThisTime);
+            rendered += numThisTime;
+            CHECK (voices.getRemaining (id) == remaining - rendered);
+        }
+
+        CHECK (voices.isActive (id));
+        voices.render (output, 0, 1);
+        CHECK_FALSE (voices.isActive (id));
+
+        auto faded = voices.start (&sample, nullptr, 0, numSamples);
+        voices.render (output, 0, 10);
+        voices.fadeOut (faded, 100);
+        CHECK (voices.getRemaining (faded) == 100);
+
+        voices.render (output, 0, 99);
+        CHECK (voices.isActive (faded));
+        voices.render (output, 0, 1);
+        CHECK_FALSE (voices.isActive (faded));
+    }
+
+    SECTION ("steals the oldest voice")
+    {
+        auto first = voices.start (&sample, nullptr, 0, numSamples);
+        for (int i = 1; i < VoicePool::maxVoices; ++i)
+            voices.start (&sample, nullptr, 0, numSamples);
+
+        auto stolen = voices.start (&sample, nullptr, 0, numSamples);
+        CHECK (voices.isActive (stolen));
+        CHECK_FALSE (voices.isActive (first));
+
+        // the stolen voice fades out rather than stopping mid-sample, then its slot is free again
+        CHECK (voices.getNumActive() == VoicePool::maxVoices + 1);
+
+        for (int i = 0; i < 4; ++i)
+            voices.render (output, 0, blockSize);
+
+        CHECK (voices.getNumActive() == VoicePool::maxVoices);
+    }
+
+    SECTION ("steals the quietest voice and never an unstealable one")
+    {
+        std::atomic<float> quiet { 0.1f }, loud { 1.0f };
+        voices.setStealing (VoicePool::Stealing::quietest);
+
+        auto protectedVoice = voices.start (&sample, &quiet, 0, numSamples, false);
+        auto quietest = voices.start (&sample, &quiet, 0, numSamples);
+        for (int i = 2; i < VoicePool::maxVoices; ++i)
+            voices.start (&sample, &loud, 0, numSamples);
+
+        voices.render (output, 0, blockSize);
+        voices.start (&sample, &loud, 0, numSamples);
+
+        CHECK (voices.isActive (protectedVoice));
+        CHECK_FALSE (voices.isActive (quietest));
+    }
+
+    SECTION ("hands the oldest streamed voice's stream on when every stream is busy")
+    {
+        auto longReader = createRampReader (1, 20000, 44100.0);
+        Sample streamed (juce::File(), *longReader, 44100.0, 1000.0 / 44100.0);
+        REQUIRE (streamed.isStreamed());
+
+        std::vector<VoicePool::VoiceId> ids;
+        for (int i = 0; i < VoicePool::maxStreams; ++i)
+            ids.push_back (voices.start (&streamed, nullptr, 0, streamed.getNumSamples()));
+
+        auto extra = voices.start (&streamed, nullptr, 0, streamed.getNumSamples());
+        CHECK (voices.isActive (extra));
+        CHECK (voices.getRemaining (extra) == streamed.getNumSamples());
+        CHECK_FALSE (voices.isActive (ids[0]));
+
+        for (size_t i = 1; i < ids.size(); ++i)
+            CHECK (voices.isActive (ids[i]));
+
+        // the stream is handed over once the voice that gave it up has faded out
+        CHECK (voices.getNumActive() == VoicePool::maxStreams + 2);
+
+        for (int i = 0; i < 4; ++i)
+            voices.render (output, 0, blockSize);
+
+        CHECK (voices.getNumActive() == VoicePool::maxStreams + 1);
+        CHECK (voices.isActive (extra));
+    }
+
+    SECTION ("plays only the resident head when no stream can be taken")
+    {
+        auto longReader = createRampReader (1, 20000, 44100.0);
+        Sample streamed (juce::File(), *longReader, 44100.0, 1000.0 / 44100.0);
+
+        std::vector<VoicePool::VoiceId> ids;
+        for (int i = 0; i < VoicePool::maxStreams; ++i)
+            ids.push_back (voices.start (&streamed, nullptr, 0, streamed.getNumSamples(), false));
+
+        auto head = voices.start (&streamed, nullptr, 0, streamed.getNumSamples());
+        CHECK (voices.isActive (head));
+        CHECK (voices.getRemaining (head) == streamed.getResidentLength());
+
+        auto tail = voices.start (&streamed, nullptr, streamed.getResidentLength() + 10, streamed.getNumSamples());
+        CHECK_FALSE (voices.isActive (tail));
+        CHECK (voices.getNumActive() == VoicePool::maxStreams + 1);
+
+        for (auto id : ids)
+            CHECK (voices.isActive (id));
+    }
+}
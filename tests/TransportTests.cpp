@@ -0,0 +1,78 @@
+#include <sampler/Transport.h>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+
+TEST_CASE ("Transport", "[transport]")
+{
+    using State = Transport::State;
+    using Command = Transport::Command;
+
+    Transport transport;
+    REQUIRE (transport.getState() == State::stopped);
+
+    SECTION ("applies queued commands in order")
+    {
+        std::vector<Command> received;
+        transport.send (Command::play);
+        transport.send (Command::stop);
+        transport.handleCommands ([&] (Command command) { received.push_back (command); });
+
+        CHECK (received == std::vector<Command> { Command::play, Command::stop });
+    }
+
+    SECTION ("stops only once stopping has finished")
+    {
+        CHECK (transport.apply (Command::play));
+        CHECK (transport.getState() == State::playing);
+
+        CHECK (transport.apply (Command::stop));
+        CHECK (transport.getState() == State::stopping);
+
+        CHECK_FALSE (transport.apply (Command::stop));
+        transport.finishStopping();
+        CHECK (transport.getState() == State::stopped);
+    }
+
+    SECTION ("plays again while stopping")
+    {
+        transport.apply (Command::play);
+        transport.apply (Command::stop);
+
+        CHECK (transport.apply (Command::play));
+        CHECK (transport.getState() == State::playing);
+
+        transport.finishStopping();
+        CHECK (transport.getState() == State::playing);
+    }
+
+    SECTION ("ignores stop while stopped")
+    {
+        CHECK_FALSE (transport.apply (Command::stop));
+        CHECK (transport.getState() == State::stopped);
+    }
+
+    SECTION ("takes commands from several senders at once")
+    {
+        std::atomic<int> sent { 0 };
+        int received = 0;
+
+        std::vector<std::thread> senders;
+        for (int i = 0; i < 4; ++i)
+            senders.emplace_back ([&] {
+                for (int n = 0; n < 1000; ++n)
+                    while (!transport.send (Command::play))
+                        std::this_thread::yield();
+
+                sent.fetch_add (1000);
+            });
+
+        while (sent.load() < 4000)
+            received += transport.handleCommands ([] (Command) {});
+
+        for (auto& sender : senders)
+            sender.join();
+
+        received += transport.handleCommands ([] (Command) {});
+        CHECK (received == 4000);
+    }
+}
@@ -0,0 +1,69 @@
+#include <utils/RealtimeWorkerPool.h>
+#include <catch2/catch_test_macros.hpp>
+#include <array>
+#include <functional>
+
+TEST_CASE ("Realtime worker pool", "[workers]")
+{
+    std::function<void (int)> job = [] (int) {};
+    RealtimeWorkerPool pool (3, [&job] (int index) { job (index); });
+    pool.prepare (44100.0, 512);
+    REQUIRE (pool.getNumWorkers() == 3);
+
+    SECTION ("runs every job of a batch exactly once")
+    {
+        std::array<std::atomic<int>, 5> runs {};
+        job = [&runs] (int index) { runs[(size_t) index].fetch_add (1); };
+
+        for (int batch = 0; batch < 1000; ++batch)
+            pool.run (0b11111);
+
+        for (auto& count : runs)
+            CHECK (count.load() == 1000);
+    }
+
+    SECTION ("returns only once every job has finished")
+    {
+        std::atomic<int> finished { 0 };
+        job = [&finished] (int) {
+            juce::Thread::sleep (5);
+            finished.fetch_add (1);
+        };
+
+        pool.run (0b1111);
+        CHECK (finished.load() == 4);
+    }
+
+    SECTION ("runs only the jobs asked for")
+    {
+        std::atomic<int> total { 0 };
+        job = [&total] (int index) { total.fetch_add (index + 1); };
+
+        pool.run (0b10101);
+        CHECK (total.load() == 1 + 3 + 5);
+    }
+
+    SECTION ("waits for a job a worker is still running")
+    {
+        std::atomic<bool> workerStarted { false };
+        std::atomic<bool> workerFinished { false };
+
+        // whichever job a worker takes runs long after the caller's own one is done
+        job = [&] (int) {
+            if (juce::Thread::getCurrentThread() == nullptr)
+            {
+                while (!workerStarted.load())
+                    juce::Thread::yield();
+
+                return;
+            }
+
+            workerStarted.store (true);
+            juce::Thread::sleep (20);
+            workerFinished.store (true);
+        };
+
+        pool.run (0b11);
+        CHECK (workerFinished.load());
+    }
+}